@@ -0,0 +1,182 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Automorphisms of a graph and symmetry reduction for the searches. An
+//automorphism maps vertices to vertices so that every edge goes to an edge,
+//which also maps the slots of a labeling to each other. Moving the labels of a
+//magic labeling along an automorphism gives another magic labeling with the
+//same magic number, so the labelings split up into orbits.
+//
+//Only the lexicographically smallest labeling of each orbit is searched for.
+//Since the labels are all different, comparing a labeling with its image
+//under an automorphism is decided at the first slot the automorphism moves, so
+//each automorphism other than the identity gives one constraint of the form
+//label[a] < label[b]. The same reasoning means no automorphism other than the
+//identity can fix a labeling, so every orbit has exactly as many labelings as
+//there are automorphisms.
+
+#ifndef AUTOMORPHISM_H
+#define AUTOMORPHISM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+//Struct for the automorphism group of a graph, stored as the permutation of
+//the slots for each automorphism, and the lex leader constraint for each one
+//other than the identity
+struct Symmetry {
+	int permSize;
+	int order;
+	std::vector<int> slotMaps;
+
+	//Labels must satisfy label[lessSlot[i]] < label[greaterSlot[i]]
+	int numConstraints;
+	std::vector<int> lessSlot;
+	std::vector<int> greaterSlot;
+};
+
+struct Symmetry computeSymmetry(int vertices, int edges, int** matrix);
+void findAutomorphisms(struct Symmetry* symmetry, int vertices, int** matrix,
+	int* degreeIn, int* degreeOut, int* image, int* used, int vertex);
+int isCanonical(struct Symmetry* symmetry, const int* labeling);
+
+/**
+ * Find every automorphism of a graph and the constraints that pick out the
+ * smallest labeling of each orbit
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @return A struct of the automorphism group
+ */
+struct Symmetry computeSymmetry(int vertices, int edges, int** matrix) {
+	struct Symmetry symmetry;
+	symmetry.permSize = vertices + edges;
+	symmetry.order = 0;
+	symmetry.numConstraints = 0;
+
+	//Only vertices with the same in and out degree can map to each other
+	int degreeIn[vertices];
+	int degreeOut[vertices];
+	for (int i1 = 0; i1 < vertices; i1++) {
+		degreeIn[i1] = 0;
+		degreeOut[i1] = 0;
+	}
+	for (int i1 = 0; i1 < vertices; i1++) {
+		for (int i2 = 0; i2 < vertices; i2++) {
+			if (matrix[i1][i2]) {
+				degreeOut[i1]++;
+				degreeIn[i2]++;
+			}
+		}
+	}
+
+	int image[vertices];
+	int used[vertices];
+	for (int i1 = 0; i1 < vertices; i1++) {
+		used[i1] = 0;
+	}
+	findAutomorphisms(&symmetry, vertices, matrix, degreeIn, degreeOut, image, used, 0);
+
+	//Each automorphism other than the identity is decided at the first slot
+	//it moves
+	int permSize = symmetry.permSize;
+	for (int i1 = 0; i1 < symmetry.order; i1++) {
+		int* slotMap = &symmetry.slotMaps[i1 * permSize];
+		int first = 0;
+		while (first < permSize && slotMap[first] == first) {
+			first++;
+		}
+		if (first == permSize) {
+			continue;
+		}
+
+		//The image of a labeling has label[b] at slot first, where b is the
+		//slot that maps to first
+		int from = 0;
+		while (slotMap[from] != first) {
+			from++;
+		}
+		symmetry.lessSlot.push_back(first);
+		symmetry.greaterSlot.push_back(from);
+		symmetry.numConstraints++;
+	}
+
+	return symmetry;
+}
+
+/**
+ * Extend a partial vertex mapping in every way that keeps edges as edges, and
+ * store the slot permutation of each complete mapping
+ * @param symmetry The group being built
+ * @param vertices The number of vertices in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param degreeIn The in degree of each vertex
+ * @param degreeOut The out degree of each vertex
+ * @param image The image of each vertex mapped so far
+ * @param used Whether each vertex is already an image
+ * @param vertex The next vertex to map
+ */
+void findAutomorphisms(struct Symmetry* symmetry, int vertices, int** matrix,
+	int* degreeIn, int* degreeOut, int* image, int* used, int vertex) {
+	if (vertex == vertices) {
+		//Edge slots follow their end points
+		int permSize = symmetry->permSize;
+		int start = symmetry->slotMaps.size();
+		symmetry->slotMaps.resize(start + permSize);
+		int* slotMap = &symmetry->slotMaps[start];
+		for (int slot = 0; slot < permSize; slot++) {
+			slotMap[slot] = slot;
+		}
+		for (int i1 = 0; i1 < vertices; i1++) {
+			slotMap[i1] = image[i1];
+			for (int i2 = 0; i2 < vertices; i2++) {
+				int edge = matrix[i1][i2];
+				if (edge) {
+					slotMap[vertices + edge - 1] = vertices + matrix[image[i1]][image[i2]] - 1;
+				}
+			}
+		}
+		symmetry->order++;
+		return;
+	}
+
+	for (int target = 0; target < vertices; target++) {
+		if (used[target] || degreeIn[target] != degreeIn[vertex] ||
+			degreeOut[target] != degreeOut[vertex]) {
+			continue;
+		}
+
+		//Edges to and from the vertices already mapped have to match up
+		int works = (matrix[vertex][vertex] != 0) == (matrix[target][target] != 0);
+		for (int i1 = 0; i1 < vertex && works; i1++) {
+			if ((matrix[i1][vertex] != 0) != (matrix[image[i1]][target] != 0) ||
+				(matrix[vertex][i1] != 0) != (matrix[target][image[i1]] != 0)) {
+				works = 0;
+			}
+		}
+
+		if (works) {
+			image[vertex] = target;
+			used[target] = 1;
+			findAutomorphisms(symmetry, vertices, matrix, degreeIn, degreeOut, image, used, vertex + 1);
+			used[target] = 0;
+		}
+	}
+}
+
+/**
+ * Check if a labeling is the smallest one in its orbit
+ * @param symmetry The automorphism group
+ * @param labeling The label of each slot
+ * @return 1 if the labeling is the smallest, 0 if not
+ */
+int isCanonical(struct Symmetry* symmetry, const int* labeling) {
+	for (int i1 = 0; i1 < symmetry->numConstraints; i1++) {
+		if (labeling[symmetry->lessSlot[i1]] > labeling[symmetry->greaterSlot[i1]]) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+#endif
@@ -0,0 +1,483 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Depth first search for subtractive vertex magic labelings. Instead of
+//building every permutation and checking it, labels are assigned one slot at a
+//time in slot order, and the search backs up as soon as a vertex with all of
+//its slots assigned misses the magic number, or a vertex that is still open
+//cannot reach it with the labels that are left.
+//
+//Labels are tried in increasing order at every slot, so labelings are found in
+//the same order as std::next_permutation would find them, and the index of each
+//labeling is the same permutation index used by the brute force loop. A search
+//can be limited to a range of permutation indexes so it can be split up in the
+//same way as the brute force loop.
+//
+//With the automorphisms of the graph, each lex leader constraint is checked as
+//soon as both of its slots are assigned, so only the smallest labeling of each
+//orbit is searched for.
+//
+//The labels allowed in the vertex slots can be limited to a set, with the edge
+//slots getting the rest, and the magic number can be fixed ahead of time or
+//limited to a range. A search over a range of magic numbers can also be split
+//into one search for each of them, with the units of work numbered as in
+//magic_range.h.
+
+#ifndef BACKTRACK_H
+#define BACKTRACK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "incidence.h"
+#include "magic_range.h"
+#include "perm_index.h"
+#include "results.h"
+#include "automorphism.h"
+
+//Struct for the backtracking search, holding the incidence of the graph, the
+//order vertices are closed in, and the state of the current search
+struct Backtracker {
+	struct Incidence inc;
+	int permSize;
+
+	//Vertices touched by each slot, and whether the slot is added or subtracted
+	int* touchStart;
+	int* touchVertex;
+	int* touchSign;
+
+	//Vertices whose last slot is each slot, the magic vertex first
+	int* closeStart;
+	int* closeVertex;
+	int* closeDepth;
+
+	//The first vertex to be closed, which sets the magic number
+	int magicVertex;
+
+	//Lex leader constraints checked at each slot, the label of the slot has to
+	//be smaller than the label of orderSlot if orderLess, larger if not
+	int* orderStart;
+	int* orderSlot;
+	int* orderLess;
+
+	//Number of permutations below a slot, (permSize - 1 - depth)!
+	PermIndex* blockSize;
+
+	//Labels allowed in the vertex slots and in the edge slots, and whether
+	//the magic number is fixed before the search starts
+	unsigned long long vertexLabels;
+	unsigned long long edgeLabels;
+	int magicFixed;
+
+	//The magic numbers to search for when the magic number is not fixed
+	struct MagicRange magic;
+
+	//Search state
+	int* labels;
+	int* partial;
+	int* plusLeft;
+	int* minusLeft;
+	unsigned long long freeLabels;
+	int magicNumber;
+	PermIndex start;
+	PermIndex end;
+	struct Results* results;
+};
+
+struct Backtracker createBacktracker(int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry);
+void backtrackRange(struct Backtracker* bt, PermIndex start, PermIndex end,
+	struct Results* results);
+PermIndex backtrackMagicUnits(int permSize, struct MagicRange magic);
+void backtrackMagicRange(struct Backtracker* bt, struct MagicRange magic,
+	PermIndex unitStart, PermIndex unitEnd, struct Results* results);
+void freeBacktracker(struct Backtracker* bt);
+void backtrackSearch(struct Backtracker* bt, int depth, PermIndex base, int inside);
+int assignSlot(struct Backtracker* bt, int depth, int label);
+void unassignSlot(struct Backtracker* bt, int depth, int label);
+
+/**
+ * Set up a backtracking search for a graph
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param symmetry The automorphisms of the graph to only find the smallest
+ *                 labeling of each orbit, or NULL to find every labeling
+ * @return A struct for the search, freed with freeBacktracker
+ */
+struct Backtracker createBacktracker(int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry) {
+	struct Backtracker bt;
+	bt.inc = buildIncidence(vertices, edges, matrix);
+	int permSize = vertices + edges;
+	bt.permSize = permSize;
+
+	if (permSize > 64) {
+		printf("The backtracking engine supports at most 64 labels.\n");
+		exit(1);
+	}
+
+	struct Incidence* inc = &bt.inc;
+	int incSize = inc->start[vertices];
+
+	//Each vertex is closed when its highest slot is assigned
+	bt.closeDepth = (int *) malloc(vertices * sizeof(int));
+	bt.magicVertex = 0;
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		int last = 0;
+		for (int i1 = inc->start[vertex]; i1 < inc->start[vertex + 1]; i1++) {
+			if (inc->slot[i1] > last) {
+				last = inc->slot[i1];
+			}
+		}
+		bt.closeDepth[vertex] = last;
+		if (last < bt.closeDepth[bt.magicVertex]) {
+			bt.magicVertex = vertex;
+		}
+	}
+
+	//Invert the incidence lists so each slot knows the vertices it touches,
+	//and group the vertices by the slot that closes them
+	bt.touchStart = (int *) calloc(permSize + 1, sizeof(int));
+	bt.touchVertex = (int *) malloc(incSize * sizeof(int));
+	bt.touchSign = (int *) malloc(incSize * sizeof(int));
+	bt.closeStart = (int *) calloc(permSize + 1, sizeof(int));
+	bt.closeVertex = (int *) malloc(vertices * sizeof(int));
+
+	for (int i1 = 0; i1 < incSize; i1++) {
+		bt.touchStart[inc->slot[i1] + 1]++;
+	}
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		bt.closeStart[bt.closeDepth[vertex] + 1]++;
+	}
+	for (int slot = 0; slot < permSize; slot++) {
+		bt.touchStart[slot + 1] += bt.touchStart[slot];
+		bt.closeStart[slot + 1] += bt.closeStart[slot];
+	}
+
+	int touchCount[permSize];
+	int closeCount[permSize];
+	for (int slot = 0; slot < permSize; slot++) {
+		touchCount[slot] = bt.touchStart[slot];
+		closeCount[slot] = bt.closeStart[slot];
+	}
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		for (int i1 = inc->start[vertex]; i1 < inc->start[vertex + 1]; i1++) {
+			int slot = inc->slot[i1];
+			bt.touchVertex[touchCount[slot]] = vertex;
+			bt.touchSign[touchCount[slot]] = inc->sign[i1];
+			touchCount[slot]++;
+		}
+	}
+
+	//The magic vertex goes first so the magic number is set before the other
+	//vertices closed by the same slot are checked
+	bt.closeVertex[closeCount[bt.closeDepth[bt.magicVertex]]++] = bt.magicVertex;
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		if (vertex != bt.magicVertex) {
+			bt.closeVertex[closeCount[bt.closeDepth[vertex]]++] = vertex;
+		}
+	}
+
+	//Each lex leader constraint is checked at the later of its two slots
+	int numConstraints = symmetry != NULL ? symmetry->numConstraints : 0;
+	bt.orderStart = (int *) calloc(permSize + 1, sizeof(int));
+	bt.orderSlot = (int *) malloc((numConstraints + 1) * sizeof(int));
+	bt.orderLess = (int *) malloc((numConstraints + 1) * sizeof(int));
+	for (int i1 = 0; i1 < numConstraints; i1++) {
+		int later = std::max(symmetry->lessSlot[i1], symmetry->greaterSlot[i1]);
+		bt.orderStart[later + 1]++;
+	}
+	int orderCount[permSize];
+	for (int slot = 0; slot < permSize; slot++) {
+		bt.orderStart[slot + 1] += bt.orderStart[slot];
+		orderCount[slot] = bt.orderStart[slot];
+	}
+	for (int i1 = 0; i1 < numConstraints; i1++) {
+		int less = symmetry->lessSlot[i1];
+		int greater = symmetry->greaterSlot[i1];
+		int later = std::max(less, greater);
+		bt.orderSlot[orderCount[later]] = later == less ? greater : less;
+		bt.orderLess[orderCount[later]] = later == less;
+		orderCount[later]++;
+	}
+
+	bt.blockSize = (PermIndex *) malloc(permSize * sizeof(PermIndex));
+	PermIndex fac = 1;
+	for (int depth = permSize - 1; depth >= 0; depth--) {
+		bt.blockSize[depth] = fac;
+		fac *= permSize - depth;
+	}
+
+	bt.labels = (int *) malloc(permSize * sizeof(int));
+	bt.partial = (int *) malloc(vertices * sizeof(int));
+	bt.plusLeft = (int *) malloc(vertices * sizeof(int));
+	bt.minusLeft = (int *) malloc(vertices * sizeof(int));
+	bt.magicNumber = 0;
+	bt.vertexLabels = ~0ULL;
+	bt.edgeLabels = ~0ULL;
+	bt.magicFixed = 0;
+	bt.magic.low = -(1 << 30);
+	bt.magic.high = 1 << 30;
+	bt.results = NULL;
+
+	return bt;
+}
+
+/**
+ * Find every labeling with a permutation index in [start, end). The index and
+ * magic number of each labeling found are added to the results in order.
+ * @param bt The search to run
+ * @param start The first permutation index to check
+ * @param end One past the last permutation index to check
+ * @param results The results to add the labelings found to
+ */
+void backtrackRange(struct Backtracker* bt, PermIndex start, PermIndex end,
+	struct Results* results) {
+	struct Incidence* inc = &bt->inc;
+
+	//Reset the state, nothing is assigned
+	bt->freeLabels = bt->permSize == 64 ? ~0ULL : (1ULL << bt->permSize) - 1;
+	for (int vertex = 0; vertex < inc->vertices; vertex++) {
+		bt->partial[vertex] = 0;
+		bt->plusLeft[vertex] = 0;
+		bt->minusLeft[vertex] = 0;
+		for (int i1 = inc->start[vertex]; i1 < inc->start[vertex + 1]; i1++) {
+			if (inc->sign[i1] > 0) {
+				bt->plusLeft[vertex]++;
+			} else {
+				bt->minusLeft[vertex]++;
+			}
+		}
+	}
+
+	bt->start = start;
+	bt->end = end;
+	bt->results = results;
+
+	if (start < end) {
+		backtrackSearch(bt, 0, 0, 0);
+	}
+}
+
+/**
+ * The number of units of work when the search is split by magic number, one
+ * for each permutation index and magic number
+ * @param permSize The number of labels
+ * @param magic The range of magic numbers
+ * @return The number of units
+ */
+PermIndex backtrackMagicUnits(int permSize, struct MagicRange magic) {
+	PermIndex numPermutations = factorialIndex(permSize);
+	int size = magicRangeSize(magic);
+	if (size > 0 && numPermutations > ~(PermIndex) 0 / size) {
+		printf("%d magic numbers of %d! permutations is too many to split up.\n", size, permSize);
+		exit(1);
+	}
+	return numPermutations * size;
+}
+
+/**
+ * Find every labeling in a range of units, where each unit is a permutation
+ * index together with a magic number. The units of each magic number are
+ * searched with the magic number fixed, and the index and magic number of each
+ * labeling found are added to the results, in order for each magic number.
+ * @param bt The search to run
+ * @param magic The range of magic numbers the units cover
+ * @param unitStart The first unit to search
+ * @param unitEnd One past the last unit to search
+ * @param results The results to add the labelings found to
+ */
+void backtrackMagicRange(struct Backtracker* bt, struct MagicRange magic,
+	PermIndex unitStart, PermIndex unitEnd, struct Results* results) {
+	PermIndex numPermutations = bt->blockSize[0] * bt->permSize;
+	int magicFixed = bt->magicFixed;
+	bt->magicFixed = 1;
+
+	PermIndex unit = unitStart;
+	while (unit < unitEnd && !searchStopped(results)) {
+		//Search up to the end of this magic number's units
+		int k = divideIndex(unit, numPermutations);
+		PermIndex kStart = k * numPermutations;
+		PermIndex kEnd = kStart + numPermutations < unitEnd ? kStart + numPermutations : unitEnd;
+		bt->magicNumber = magic.low + k;
+		backtrackRange(bt, unit - kStart, kEnd - kStart, results);
+		unit = kEnd;
+	}
+
+	bt->magicFixed = magicFixed;
+}
+
+/**
+ * Try every free label in the slot at the given depth and search below it
+ * @param bt The search
+ * @param depth The slot to assign
+ * @param base The permutation index of the first labeling below this point
+ * @param inside 1 if every labeling below this point is in [start, end)
+ */
+void backtrackSearch(struct Backtracker* bt, int depth, PermIndex base, int inside) {
+	if (depth == bt->permSize) {
+		addResult(bt->results, base, bt->magicNumber);
+		return;
+	}
+	if (searchStopped(bt->results)) {
+		return;
+	}
+
+	PermIndex block = bt->blockSize[depth];
+	unsigned long long allowed = depth < bt->inc.vertices ? bt->vertexLabels : bt->edgeLabels;
+	unsigned long long candidates = bt->freeLabels;
+	PermIndex childStart = base;
+	while (candidates) {
+		int label = __builtin_ctzll(candidates) + 1;
+		candidates &= candidates - 1;
+
+		//The j-th smallest free label covers the j-th block of indexes
+		PermIndex childEnd = childStart + block;
+		if (!(allowed & (1ULL << (label - 1)))) {
+			childStart = childEnd;
+			continue;
+		}
+		int childInside = inside;
+		if (!inside) {
+			if (childEnd <= bt->start) {
+				childStart = childEnd;
+				continue;
+			}
+			if (childStart >= bt->end) {
+				break;
+			}
+			childInside = childStart >= bt->start && childEnd <= bt->end;
+		}
+
+		if (assignSlot(bt, depth, label)) {
+			backtrackSearch(bt, depth + 1, childStart, childInside);
+		}
+		unassignSlot(bt, depth, label);
+
+		childStart = childEnd;
+	}
+}
+
+/**
+ * Put a label in a slot and check the vertices it affects
+ * @param bt The search
+ * @param depth The slot to assign
+ * @param label The label to put in the slot
+ * @return 1 if the labeling can still work, 0 if the search should back up
+ */
+int assignSlot(struct Backtracker* bt, int depth, int label) {
+	bt->labels[depth] = label;
+	bt->freeLabels &= ~(1ULL << (label - 1));
+
+	for (int i1 = bt->touchStart[depth]; i1 < bt->touchStart[depth + 1]; i1++) {
+		int vertex = bt->touchVertex[i1];
+		if (bt->touchSign[i1] > 0) {
+			bt->partial[vertex] += label;
+			bt->plusLeft[vertex]--;
+		} else {
+			bt->partial[vertex] -= label;
+			bt->minusLeft[vertex]--;
+		}
+	}
+
+	//Check the lex leader constraints that are now decided
+	for (int i1 = bt->orderStart[depth]; i1 < bt->orderStart[depth + 1]; i1++) {
+		int other = bt->labels[bt->orderSlot[i1]];
+		if (bt->orderLess[i1] ? label > other : label < other) {
+			return 0;
+		}
+	}
+
+	//Check the vertices this slot closes against the magic number
+	for (int i1 = bt->closeStart[depth]; i1 < bt->closeStart[depth + 1]; i1++) {
+		int vertex = bt->closeVertex[i1];
+		if (vertex == bt->magicVertex && !bt->magicFixed) {
+			bt->magicNumber = bt->partial[vertex];
+			if (!inMagicRange(bt->magic, bt->magicNumber)) {
+				return 0;
+			}
+		} else if (bt->partial[vertex] != bt->magicNumber) {
+			return 0;
+		}
+	}
+
+	if (bt->freeLabels == 0) {
+		return 1;
+	}
+
+	//Bound the value of each open vertex using the smallest and largest free
+	//labels. Once the magic number is known it has to be in every bound,
+	//before that the bounds of all the vertices have to overlap within the
+	//range of magic numbers.
+	int minFree = __builtin_ctzll(bt->freeLabels) + 1;
+	int maxFree = 64 - __builtin_clzll(bt->freeLabels);
+	int magicKnown = bt->magicFixed || depth >= bt->closeDepth[bt->magicVertex];
+	int low = magicKnown ? bt->magicNumber : bt->magic.low;
+	int high = magicKnown ? bt->magicNumber : bt->magic.high;
+	for (int vertex = 0; vertex < bt->inc.vertices; vertex++) {
+		int vertexLow = bt->partial[vertex];
+		int vertexHigh = bt->partial[vertex];
+		if (bt->closeDepth[vertex] > depth) {
+			vertexLow += bt->plusLeft[vertex] * minFree - bt->minusLeft[vertex] * maxFree;
+			vertexHigh += bt->plusLeft[vertex] * maxFree - bt->minusLeft[vertex] * minFree;
+		}
+		if (vertexLow > low) {
+			low = vertexLow;
+		}
+		if (vertexHigh < high) {
+			high = vertexHigh;
+		}
+		if (low > high) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * Take a label back out of a slot, undoing assignSlot
+ * @param bt The search
+ * @param depth The slot to clear
+ * @param label The label in the slot
+ */
+void unassignSlot(struct Backtracker* bt, int depth, int label) {
+	bt->freeLabels |= 1ULL << (label - 1);
+
+	for (int i1 = bt->touchStart[depth]; i1 < bt->touchStart[depth + 1]; i1++) {
+		int vertex = bt->touchVertex[i1];
+		if (bt->touchSign[i1] > 0) {
+			bt->partial[vertex] -= label;
+			bt->plusLeft[vertex]++;
+		} else {
+			bt->partial[vertex] += label;
+			bt->minusLeft[vertex]++;
+		}
+	}
+}
+
+/**
+ * Free the arrays of a backtracking search
+ * @param bt The search to free
+ */
+void freeBacktracker(struct Backtracker* bt) {
+	freeIncidence(&bt->inc);
+	free(bt->touchStart);
+	free(bt->touchVertex);
+	free(bt->touchSign);
+	free(bt->closeStart);
+	free(bt->closeVertex);
+	free(bt->closeDepth);
+	free(bt->orderStart);
+	free(bt->orderSlot);
+	free(bt->orderLess);
+	free(bt->blockSize);
+	free(bt->labels);
+	free(bt->partial);
+	free(bt->plusLeft);
+	free(bt->minusLeft);
+}
+
+#endif
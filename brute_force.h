@@ -0,0 +1,104 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//The brute force loop over a range of permutations, shared by the sequential,
+//OpenMP and MPI programs. Each permutation is checked with the compiled kernel
+//for the graph when there is one, or with vertex values kept up to date as
+//the permutation changes, and blocks of permutations that fail in the same
+//way are skipped.
+
+#ifndef BRUTE_FORCE_H
+#define BRUTE_FORCE_H
+
+#include <vector>
+
+#include "automorphism.h"
+#include "family_kernels.h"
+#include "incremental.h"
+#include "magic_range.h"
+#include "perm_index.h"
+#include "perm_range.h"
+#include "perm_rank.h"
+#include "prefix_skip.h"
+#include "results.h"
+
+void bruteRange(int vertices, int edges, int** matrix, int reorder, FamilyKernel kernel,
+	struct Symmetry* symmetry, struct MagicRange magic, struct PermRange* range,
+	struct Results* results);
+
+/**
+ * Check every permutation left in a range. The index and magic number of each
+ * labeling found are added to the results, in index order unless the slots
+ * are reordered.
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param reorder 1 to reorder the slots so vertices close early, 0 to keep
+ *                the slots in order
+ * @param kernel The check compiled for the graph, or NULL to keep the vertex
+ *               values up to date instead
+ * @param symmetry The automorphisms of the graph to only keep the smallest
+ *                 labeling of each orbit, or NULL to keep every labeling
+ * @param magic The magic numbers to search for
+ * @param range The permutations to check, moved to the end of the range
+ * @param results The results to add the labelings found to
+ */
+void bruteRange(int vertices, int edges, int** matrix, int reorder, FamilyKernel kernel,
+	struct Symmetry* symmetry, struct MagicRange magic, struct PermRange* range,
+	struct Results* results) {
+	int permSize = vertices + edges;
+	int* permutation = range->permutation;
+
+	//Skip over blocks of permutations that fail in the same way
+	struct PrefixSkip ps = createPrefixSkip(vertices, edges, matrix, reorder);
+	int labeling[permSize];
+
+	//Keep the vertex values up to date instead of adding them up each time
+	struct IncrementalEval ie = createIncrementalEval(vertices, edges, matrix, &ps, permutation);
+
+	int magicNumber, check, works;
+	while (range->index < range->end && !searchStopped(results)) {
+		if (kernel != NULL) {
+			check = kernel(permutation, &magicNumber);
+			works = check < 0;
+		} else {
+			//The first vertex checked sets the magic number, and when it is
+			//out of range everything sharing the slots of that vertex is too
+			magicNumber = ie.values[ps.checkOrder[0]];
+			works = inMagicRange(magic, magicNumber);
+			check = 0;
+			if (works) {
+				for (check = 1; check < vertices; check++) {
+					if (ie.values[ps.checkOrder[check]] != magicNumber) {
+						works = 0;
+						break;
+					}
+				}
+			}
+		}
+
+		if (works) {
+			//Only keep the smallest labeling of each orbit
+			slotOrderLabeling(&ps, permutation, labeling);
+			if (inMagicRange(magic, magicNumber) && (symmetry == NULL || isCanonical(symmetry, labeling))) {
+				//Store the index of the labeling in slot order
+				PermIndex idx = reorder ? rankPermutation(labeling, permSize) : range->index;
+				addResult(results, idx, magicNumber);
+			}
+
+			stepRange(range);
+		} else {
+			//Jump past every permutation sharing the prefix the check used
+			skipRangePrefix(range, &ps, check);
+		}
+
+		//Only the positions from the first change on move the vertex values
+		if (kernel == NULL) {
+			updateIncrementalEval(&ie, permutation, range->changed);
+		}
+	}
+
+	freePrefixSkip(&ps);
+	freeIncrementalEval(&ie);
+}
+
+#endif
@@ -0,0 +1,160 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Checks generated at run time for graphs that have no compiled family
+//kernel, like graphs read from a file. The check for the graph is written out
+//as a C++ function with every vertex sum spelled out, compiled into a shared
+//library with the local compiler, and loaded with dlopen. The libraries are
+//kept in vertex_magic_cache/ under a hash of the adjacency matrix, so each
+//graph is only compiled once.
+//
+//The generated function has the same form as the family kernels: it checks
+//the vertices in the order of the brute force loop and returns the index in
+//that order of the first one that misses. The compiler is c++, or $CXX if it
+//is set.
+//
+//Only the brute force loop uses it. The backtracking, plain changes, and SIMD
+//engines check vertices one slot, one swap, or one batch at a time, which a
+//check of the whole permutation cannot replace.
+
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "incidence.h"
+#include "prefix_skip.h"
+#include "family_kernels.h"
+
+#define CODEGEN_CACHE "vertex_magic_cache"
+#define CODEGEN_FUNCTION "vertexMagicCheck"
+
+FamilyKernel compileGraphKernel(int vertices, int edges, int** matrix, int reorder);
+unsigned long long hashGraph(int vertices, int** matrix, int reorder);
+int writeGraphKernel(const char* filename, int vertices, int edges, int** matrix,
+	int reorder, unsigned long long hash);
+
+/**
+ * Get a check generated for a graph, compiling it if it is not in the cache
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param reorder 1 if the brute force loop reorders the slots, 0 if not
+ * @return The generated check, or NULL if it could not be built
+ */
+FamilyKernel compileGraphKernel(int vertices, int edges, int** matrix, int reorder) {
+	unsigned long long hash = hashGraph(vertices, matrix, reorder);
+	char library[256];
+	sprintf(library, "%s/check_%016llx.so", CODEGEN_CACHE, hash);
+
+	if (access(library, F_OK) == -1) {
+		mkdir(CODEGEN_CACHE, 0755);
+
+		//Build under names of our own and move the library into place, so
+		//processes building the same graph at once do not see half a file
+		char source[256];
+		char temp[256];
+		sprintf(source, "%s/check_%016llx_%d.cpp", CODEGEN_CACHE, hash, getpid());
+		sprintf(temp, "%s/check_%016llx_%d.so", CODEGEN_CACHE, hash, getpid());
+		if (!writeGraphKernel(source, vertices, edges, matrix, reorder, hash)) {
+			printf("An error occured writing %s.\n", source);
+			return NULL;
+		}
+
+		const char* compiler = getenv("CXX") != NULL ? getenv("CXX") : "c++";
+		char command[1024];
+		sprintf(command, "%s -O3 -shared -fPIC %s -o %s", compiler, source, temp);
+		int status = system(command);
+		remove(source);
+		if (status != 0 || rename(temp, library) != 0) {
+			printf("An error occured compiling the check for the graph.\n");
+			remove(temp);
+			return NULL;
+		}
+	}
+
+	//The library stays loaded until the program exits
+	void* handle = dlopen(library, RTLD_NOW);
+	if (handle == NULL) {
+		printf("An error occured loading %s: %s\n", library, dlerror());
+		return NULL;
+	}
+	FamilyKernel kernel = (FamilyKernel) dlsym(handle, CODEGEN_FUNCTION);
+	if (kernel == NULL) {
+		printf("An error occured loading %s: %s\n", library, dlerror());
+	}
+	return kernel;
+}
+
+/**
+ * Hash the adjacency matrix of a graph along with the slot order
+ * @param vertices The number of vertices in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param reorder 1 if the slots are reordered, 0 if not
+ * @return The hash
+ */
+unsigned long long hashGraph(int vertices, int** matrix, int reorder) {
+	//FNV-1a over every entry
+	unsigned long long hash = 14695981039346656037ULL;
+	hash = (hash ^ vertices) * 1099511628211ULL;
+	hash = (hash ^ reorder) * 1099511628211ULL;
+	for (int i1 = 0; i1 < vertices; i1++) {
+		for (int i2 = 0; i2 < vertices; i2++) {
+			hash = (hash ^ matrix[i1][i2]) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+/**
+ * Write out the source of the check for a graph
+ * @param filename The file to write
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param reorder 1 if the slots are reordered, 0 if not
+ * @param hash The hash of the graph, for the comment at the top
+ * @return 1 if the file was written, 0 if not
+ */
+int writeGraphKernel(const char* filename, int vertices, int edges, int** matrix,
+	int reorder, unsigned long long hash) {
+	FILE* file = fopen(filename, "w");
+	if (file == NULL) {
+		return 0;
+	}
+
+	//Check the vertices in the same order, at the same positions, as the
+	//brute force loop
+	struct PrefixSkip ps = createPrefixSkip(vertices, edges, matrix, reorder);
+	struct Incidence inc = buildIncidence(vertices, edges, matrix);
+
+	fprintf(file, "//Check generated for the graph with hash %016llx\n", hash);
+	fprintf(file, "extern \"C\" int %s(const int* p, int* magicNumber) {\n", CODEGEN_FUNCTION);
+	for (int check = 0; check < vertices; check++) {
+		int vertex = ps.checkOrder[check];
+		fprintf(file, check == 0 ? "\tint magic =" : "\tif (");
+		for (int i1 = inc.start[vertex]; i1 < inc.start[vertex + 1]; i1++) {
+			int pos = ps.position[inc.slot[i1]];
+			if (i1 == inc.start[vertex]) {
+				fprintf(file, " p[%d]", pos);
+			} else {
+				fprintf(file, " %c p[%d]", inc.sign[i1] > 0 ? '+' : '-', pos);
+			}
+		}
+		if (check == 0) {
+			fprintf(file, ";\n\t*magicNumber = magic;\n");
+		} else {
+			fprintf(file, " != magic) return %d;\n", check);
+		}
+	}
+	fprintf(file, "\treturn -1;\n}\n");
+
+	freeIncidence(&inc);
+	freePrefixSkip(&ps);
+	return fclose(file) == 0;
+}
+
+#endif
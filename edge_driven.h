@@ -0,0 +1,402 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Edge driven search for subtractive vertex magic labelings. The value of a
+//vertex is its label plus the labels of the edges in minus the labels of the
+//edges out, so once the edge labels and the magic number k are picked every
+//vertex label is fixed:
+//
+//    label(v) = k - (sum of edges in - sum of edges out)
+//
+//Only the edge labels are searched. Adding up every vertex value counts each
+//edge label once in and once out, so vertices * k is the sum of the vertex
+//labels, which are exactly the labels left over after the edges. That gives a
+//single candidate k for each edge labeling, and the vertex labels derived from
+//it are checked against the free labels with a bitmask.
+//
+//The work is split into units by the labels of the first two edges, so the
+//OpenMP and MPI programs can hand out units the same way they hand out
+//permutation indexes. Labelings are not found in index order.
+//
+//With the automorphisms of the graph, only labelings that are the smallest in
+//their orbit are kept. The range of magic numbers bounds k from the start.
+
+#ifndef EDGE_DRIVEN_H
+#define EDGE_DRIVEN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "incidence.h"
+#include "automorphism.h"
+#include "magic_range.h"
+#include "perm_rank.h"
+#include "results.h"
+
+//Struct for the edge driven search, holding which vertices each edge touches,
+//when each vertex has all of its edges, and the state of the current search
+struct EdgeSearch {
+	struct Incidence inc;
+	int vertices;
+	int edges;
+	int permSize;
+
+	//Number of edges whose labels make up a unit of work
+	int prefixDepth;
+
+	//Vertices touched by each edge, and whether the edge is in or out
+	int* touchStart;
+	int* touchVertex;
+	int* touchSign;
+
+	//Vertices whose last edge is each edge
+	int* closeStart;
+	int* closeVertex;
+
+	//Count of closed vertices with each in minus out sum, offset by diffOffset
+	int* diffUsed;
+	int diffOffset;
+
+	//The automorphisms of the graph, or NULL to keep every labeling
+	struct Symmetry* symmetry;
+
+	//The magic numbers to search for
+	struct MagicRange magic;
+
+	//Search state
+	int* labels;
+	int* diff;
+	int* kLow;
+	int* kHigh;
+	unsigned long long freeLabels;
+	int freeSum;
+	struct Results* results;
+};
+
+struct EdgeSearch createEdgeSearch(int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry, struct MagicRange magic);
+long edgeSearchUnits(int vertices, int edges);
+void edgeSearchRange(struct EdgeSearch* es, long unitStart, long unitEnd,
+	struct Results* results);
+void freeEdgeSearch(struct EdgeSearch* es);
+void edgeSearch(struct EdgeSearch* es, int depth);
+int assignEdge(struct EdgeSearch* es, int depth, int label);
+void unassignEdge(struct EdgeSearch* es, int depth, int label);
+void checkEdgeLabeling(struct EdgeSearch* es);
+
+/**
+ * Set up an edge driven search for a graph
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param symmetry The automorphisms of the graph to only keep the smallest
+ *                 labeling of each orbit, or NULL to keep every labeling
+ * @param magic The magic numbers to search for
+ * @return A struct for the search, freed with freeEdgeSearch
+ */
+struct EdgeSearch createEdgeSearch(int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry, struct MagicRange magic) {
+	struct EdgeSearch es;
+	es.symmetry = symmetry;
+	es.magic = magic;
+	es.inc = buildIncidence(vertices, edges, matrix);
+	es.vertices = vertices;
+	es.edges = edges;
+	es.permSize = vertices + edges;
+	es.prefixDepth = edges < 2 ? edges : 2;
+
+	if (es.permSize > 64) {
+		printf("The edge driven engine supports at most 64 labels.\n");
+		exit(1);
+	}
+
+	struct Incidence* inc = &es.inc;
+
+	//Each edge is in the list of the vertex it goes into and the vertex it
+	//comes out of, skipping the vertex slots at the front of each list
+	es.touchStart = (int *) calloc(edges + 1, sizeof(int));
+	es.touchVertex = (int *) malloc(2 * edges * sizeof(int));
+	es.touchSign = (int *) malloc(2 * edges * sizeof(int));
+	es.closeStart = (int *) calloc(edges + 2, sizeof(int));
+	es.closeVertex = (int *) malloc(vertices * sizeof(int));
+
+	int closeEdge[vertices];
+	int maxDegree = 0;
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		closeEdge[vertex] = -1;
+		int degree = inc->start[vertex + 1] - inc->start[vertex] - 1;
+		if (degree > maxDegree) {
+			maxDegree = degree;
+		}
+		for (int i1 = inc->start[vertex] + 1; i1 < inc->start[vertex + 1]; i1++) {
+			int edge = inc->slot[i1] - vertices;
+			es.touchStart[edge + 1]++;
+			if (edge > closeEdge[vertex]) {
+				closeEdge[vertex] = edge;
+			}
+		}
+		//Vertices with no edges are closed before the search starts, which
+		//is stored at index 0, and the rest are shifted up by one
+		es.closeStart[closeEdge[vertex] + 2]++;
+	}
+	for (int edge = 0; edge < edges; edge++) {
+		es.touchStart[edge + 1] += es.touchStart[edge];
+	}
+	for (int edge = 0; edge <= edges; edge++) {
+		es.closeStart[edge + 1] += es.closeStart[edge];
+	}
+
+	int touchCount[edges + 1];
+	int closeCount[edges + 1];
+	for (int edge = 0; edge < edges; edge++) {
+		touchCount[edge] = es.touchStart[edge];
+	}
+	for (int edge = 0; edge <= edges; edge++) {
+		closeCount[edge] = es.closeStart[edge];
+	}
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		for (int i1 = inc->start[vertex] + 1; i1 < inc->start[vertex + 1]; i1++) {
+			int edge = inc->slot[i1] - vertices;
+			es.touchVertex[touchCount[edge]] = vertex;
+			es.touchSign[touchCount[edge]] = inc->sign[i1];
+			touchCount[edge]++;
+		}
+		es.closeVertex[closeCount[closeEdge[vertex] + 1]++] = vertex;
+	}
+
+	//The in minus out sum of a vertex is at most its degree times the
+	//largest label in either direction
+	es.diffOffset = maxDegree * es.permSize;
+	es.diffUsed = (int *) calloc(2 * es.diffOffset + 1, sizeof(int));
+
+	es.labels = (int *) malloc(es.permSize * sizeof(int));
+	es.diff = (int *) malloc(vertices * sizeof(int));
+	es.kLow = (int *) malloc((edges + 1) * sizeof(int));
+	es.kHigh = (int *) malloc((edges + 1) * sizeof(int));
+	es.results = NULL;
+
+	return es;
+}
+
+/**
+ * The number of units of work, one for each way to label the first two edges
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @return The number of units
+ */
+long edgeSearchUnits(int vertices, int edges) {
+	long units = 1;
+	for (int depth = 0; depth < edges && depth < 2; depth++) {
+		units *= vertices + edges - depth;
+	}
+	return units;
+}
+
+/**
+ * Find every labeling in the units [unitStart, unitEnd). The index and magic
+ * number of each labeling found are added to the results, not in index order.
+ * @param es The search to run
+ * @param unitStart The first unit to search
+ * @param unitEnd One past the last unit to search
+ * @param results The results to add the labelings found to
+ */
+void edgeSearchRange(struct EdgeSearch* es, long unitStart, long unitEnd,
+	struct Results* results) {
+	int permSize = es->permSize;
+	es->results = results;
+
+	//Reset the state, no edges are labeled
+	es->freeLabels = permSize == 64 ? ~0ULL : (1ULL << permSize) - 1;
+	es->freeSum = permSize * (permSize + 1) / 2;
+	for (int vertex = 0; vertex < es->vertices; vertex++) {
+		es->diff[vertex] = 0;
+	}
+	for (int i1 = 0; i1 <= 2 * es->diffOffset; i1++) {
+		es->diffUsed[i1] = 0;
+	}
+
+	//Vertices with no edges are fixed from the start, and their label is k
+	es->kLow[0] = es->magic.low;
+	es->kHigh[0] = es->magic.high;
+	for (int i1 = es->closeStart[0]; i1 < es->closeStart[1]; i1++) {
+		es->diffUsed[es->diffOffset]++;
+		es->kLow[0] = std::max(es->kLow[0], 1);
+		es->kHigh[0] = std::min(es->kHigh[0], permSize);
+	}
+	if (es->kLow[0] > es->kHigh[0]) {
+		return;
+	}
+	if (es->closeStart[1] - es->closeStart[0] > 1) {
+		return;
+	}
+
+	for (long unit = unitStart; unit < unitEnd && !searchStopped(results); unit++) {
+		//Decode the first edges from the unit, each one given by the
+		//position of its label among the labels that are still free
+		int positions[2];
+		int prefix[2];
+		long rest = unit;
+		for (int depth = es->prefixDepth - 1; depth >= 0; depth--) {
+			positions[depth] = rest % (permSize - depth);
+			rest /= permSize - depth;
+		}
+
+		int assigned = 0;
+		int works = 1;
+		for (; assigned < es->prefixDepth && works; assigned++) {
+			unsigned long long candidates = es->freeLabels;
+			for (int i1 = 0; i1 < positions[assigned]; i1++) {
+				candidates &= candidates - 1;
+			}
+			prefix[assigned] = __builtin_ctzll(candidates) + 1;
+			works = assignEdge(es, assigned, prefix[assigned]);
+		}
+
+		if (works) {
+			edgeSearch(es, assigned);
+		}
+
+		while (assigned > 0) {
+			assigned--;
+			unassignEdge(es, assigned, prefix[assigned]);
+		}
+	}
+}
+
+/**
+ * Try every free label on the edge at the given depth and search below it
+ * @param es The search
+ * @param depth The edge to label
+ */
+void edgeSearch(struct EdgeSearch* es, int depth) {
+	if (depth == es->edges) {
+		checkEdgeLabeling(es);
+		return;
+	}
+	if (searchStopped(es->results)) {
+		return;
+	}
+
+	unsigned long long candidates = es->freeLabels;
+	while (candidates) {
+		int label = __builtin_ctzll(candidates) + 1;
+		candidates &= candidates - 1;
+
+		if (assignEdge(es, depth, label)) {
+			edgeSearch(es, depth + 1);
+		}
+		unassignEdge(es, depth, label);
+	}
+}
+
+/**
+ * Put a label on an edge and check the vertices that now have all their edges
+ * @param es The search
+ * @param depth The edge to label
+ * @param label The label to put on the edge
+ * @return 1 if the labeling can still work, 0 if the search should back up
+ */
+int assignEdge(struct EdgeSearch* es, int depth, int label) {
+	es->labels[es->vertices + depth] = label;
+	es->freeLabels &= ~(1ULL << (label - 1));
+	es->freeSum -= label;
+
+	for (int i1 = es->touchStart[depth]; i1 < es->touchStart[depth + 1]; i1++) {
+		es->diff[es->touchVertex[i1]] += es->touchSign[i1] * label;
+	}
+
+	int low = es->kLow[depth];
+	int high = es->kHigh[depth];
+	int works = 1;
+	for (int i1 = es->closeStart[depth + 1]; i1 < es->closeStart[depth + 2]; i1++) {
+		int diff = es->diff[es->closeVertex[i1]];
+		es->diffUsed[diff + es->diffOffset]++;
+
+		//Two vertices with the same sum would get the same label
+		if (es->diffUsed[diff + es->diffOffset] > 1) {
+			works = 0;
+		}
+
+		//The label k - diff has to be in 1 to permSize
+		if (diff + 1 > low) {
+			low = diff + 1;
+		}
+		if (diff + es->permSize < high) {
+			high = diff + es->permSize;
+		}
+	}
+	es->kLow[depth + 1] = low;
+	es->kHigh[depth + 1] = high;
+
+	return works && low <= high;
+}
+
+/**
+ * Take a label back off an edge, undoing assignEdge
+ * @param es The search
+ * @param depth The edge to clear
+ * @param label The label on the edge
+ */
+void unassignEdge(struct EdgeSearch* es, int depth, int label) {
+	for (int i1 = es->closeStart[depth + 1]; i1 < es->closeStart[depth + 2]; i1++) {
+		es->diffUsed[es->diff[es->closeVertex[i1]] + es->diffOffset]--;
+	}
+
+	for (int i1 = es->touchStart[depth]; i1 < es->touchStart[depth + 1]; i1++) {
+		es->diff[es->touchVertex[i1]] -= es->touchSign[i1] * label;
+	}
+
+	es->freeLabels |= 1ULL << (label - 1);
+	es->freeSum += label;
+}
+
+/**
+ * With every edge labeled, derive the vertex labels from the magic number and
+ * check that they are exactly the free labels
+ * @param es The search
+ */
+void checkEdgeLabeling(struct EdgeSearch* es) {
+	int vertices = es->vertices;
+	if (es->freeSum % vertices != 0) {
+		return;
+	}
+	int k = es->freeSum / vertices;
+	if (k < es->kLow[es->edges] || k > es->kHigh[es->edges]) {
+		return;
+	}
+
+	unsigned long long vertexLabels = 0;
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		int label = k - es->diff[vertex];
+		es->labels[vertex] = label;
+		vertexLabels |= 1ULL << (label - 1);
+	}
+
+	if (es->symmetry != NULL && !isCanonical(es->symmetry, es->labels)) {
+		return;
+	}
+
+	if (vertexLabels == es->freeLabels) {
+		addResult(es->results, rankPermutation(es->labels, es->permSize), k);
+	}
+}
+
+/**
+ * Free the arrays of an edge driven search
+ * @param es The search to free
+ */
+void freeEdgeSearch(struct EdgeSearch* es) {
+	freeIncidence(&es->inc);
+	free(es->touchStart);
+	free(es->touchVertex);
+	free(es->touchSign);
+	free(es->closeStart);
+	free(es->closeVertex);
+	free(es->diffUsed);
+	free(es->labels);
+	free(es->diff);
+	free(es->kLow);
+	free(es->kHigh);
+}
+
+#endif
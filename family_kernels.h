@@ -0,0 +1,160 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Checks compiled for each family of generated graphs. The graph from
+//generateGraph only depends on the cycle size and the number of connecting
+//vertices, so for the families in results/ (cycle sizes 3 to 7) the incidence
+//lists and the order the vertices are checked in are worked out at compile
+//time. Every vertex value is then a fixed sum of a few labels, and the check
+//is fully unrolled with the positions as constants.
+//
+//A kernel checks the vertices in the same order as the brute force loop and
+//returns the index in that order of the first vertex that misses, so it can
+//be used with prefix skipping. Other graphs use the generic loop.
+
+#ifndef FAMILY_KERNELS_H
+#define FAMILY_KERNELS_H
+
+#include <stddef.h>
+#include <utility>
+
+#define FAMILY_MAX_DEGREE 5
+
+//Checks the vertices of a permutation in order and returns the index of the
+//first one that misses the magic number, or -1 if the labeling is magic
+typedef int (*FamilyKernel)(const int* permutation, int* magicNumber);
+
+FamilyKernel findFamilyKernel(int cycleSize, int connectingVertices);
+
+//The incidence lists and check order of the graph from generateGraph, built
+//at compile time
+template <int C, int K>
+struct FamilyGraph {
+	static constexpr int vertices = 2 * C - K;
+	static constexpr int edges = vertices + 1;
+	static constexpr int permSize = vertices + edges;
+
+	//The slots added to and subtracted from each vertex
+	int plus[vertices][FAMILY_MAX_DEGREE];
+	int plusCount[vertices];
+	int minus[vertices][FAMILY_MAX_DEGREE];
+	int minusCount[vertices];
+
+	//The vertices in the order they are checked
+	int order[vertices];
+
+	constexpr FamilyGraph() : plus(), plusCount(), minus(), minusCount(), order() {
+		//Every vertex has its own slot
+		for (int vertex = 0; vertex < vertices; vertex++) {
+			plus[vertex][plusCount[vertex]++] = vertex;
+		}
+
+		//The same edges as generateGraph, edge numbers start at 1
+		addEdge(0, C - 1, 1);
+		addEdge(C - K, vertices - 1, C - K + 2);
+		for (int i1 = 1; i1 < vertices; i1++) {
+			addEdge(i1, i1 - 1, i1 < C - K + 1 ? i1 + 1 : i1 + 2);
+		}
+
+		//Check the vertices in the order their last slot comes up, the same
+		//as createPrefixSkip without reordering
+		int last[vertices] = {};
+		for (int vertex = 0; vertex < vertices; vertex++) {
+			for (int i1 = 0; i1 < plusCount[vertex]; i1++) {
+				last[vertex] = plus[vertex][i1] > last[vertex] ? plus[vertex][i1] : last[vertex];
+			}
+			for (int i1 = 0; i1 < minusCount[vertex]; i1++) {
+				last[vertex] = minus[vertex][i1] > last[vertex] ? minus[vertex][i1] : last[vertex];
+			}
+			order[vertex] = vertex;
+		}
+		for (int i1 = 1; i1 < vertices; i1++) {
+			int vertex = order[i1];
+			int i2 = i1;
+			while (i2 > 0 && last[order[i2 - 1]] > last[vertex]) {
+				order[i2] = order[i2 - 1];
+				i2--;
+			}
+			order[i2] = vertex;
+		}
+	}
+
+	constexpr void addEdge(int from, int to, int edge) {
+		plus[to][plusCount[to]++] = vertices + edge - 1;
+		minus[from][minusCount[from]++] = vertices + edge - 1;
+	}
+};
+
+template <int C, int K>
+struct FamilyTable {
+	static constexpr FamilyGraph<C, K> graph = FamilyGraph<C, K>();
+};
+
+/**
+ * The value of one vertex, with every slot a constant
+ * @param permutation The labels
+ * @return The value of the vertex
+ */
+template <int C, int K, int Vertex, size_t... Plus, size_t... Minus>
+inline int familyValue(const int* permutation, std::index_sequence<Plus...>, std::index_sequence<Minus...>) {
+	constexpr const FamilyGraph<C, K>& g = FamilyTable<C, K>::graph;
+	return (0 + ... + permutation[g.plus[Vertex][Plus]]) - (0 + ... + permutation[g.minus[Vertex][Minus]]);
+}
+
+template <int C, int K, int Check>
+inline int familyVertexValue(const int* permutation) {
+	constexpr const FamilyGraph<C, K>& g = FamilyTable<C, K>::graph;
+	constexpr int vertex = g.order[Check];
+	return familyValue<C, K, vertex>(permutation,
+		std::make_index_sequence<g.plusCount[vertex]>(),
+		std::make_index_sequence<g.minusCount[vertex]>());
+}
+
+/**
+ * Check the vertices from one index in the check order on
+ * @param permutation The labels
+ * @param magicNumber The value of the first vertex checked
+ * @return The index of the first vertex that misses, or -1
+ */
+template <int C, int K, int Check>
+inline int familyCheckFrom(const int* permutation, int magicNumber) {
+	if constexpr (Check == FamilyGraph<C, K>::vertices) {
+		return -1;
+	} else {
+		if (familyVertexValue<C, K, Check>(permutation) != magicNumber) {
+			return Check;
+		}
+		return familyCheckFrom<C, K, Check + 1>(permutation, magicNumber);
+	}
+}
+
+/**
+ * The kernel for one family
+ * @param permutation The labels
+ * @param magicNumber Set to the value of the first vertex checked
+ * @return The index in the check order of the first vertex that misses the
+ *         magic number, or -1 if the labeling is magic
+ */
+template <int C, int K>
+int familyKernel(const int* permutation, int* magicNumber) {
+	*magicNumber = familyVertexValue<C, K, 0>(permutation);
+	return familyCheckFrom<C, K, 1>(permutation, *magicNumber);
+}
+
+/**
+ * Find the compiled kernel for a family of generated graphs
+ * @param cycleSize The size of the cycles
+ * @param connectingVertices The number of connecting vertices
+ * @return The kernel, or NULL if the family has none
+ */
+FamilyKernel findFamilyKernel(int cycleSize, int connectingVertices) {
+	#define FAMILY(c, k) if (cycleSize == c && connectingVertices == k) return familyKernel<c, k>;
+	FAMILY(3, 1) FAMILY(3, 2)
+	FAMILY(4, 1) FAMILY(4, 2) FAMILY(4, 3)
+	FAMILY(5, 1) FAMILY(5, 2) FAMILY(5, 3) FAMILY(5, 4)
+	FAMILY(6, 1) FAMILY(6, 2) FAMILY(6, 3) FAMILY(6, 4) FAMILY(6, 5)
+	FAMILY(7, 1) FAMILY(7, 2) FAMILY(7, 3) FAMILY(7, 4) FAMILY(7, 5) FAMILY(7, 6)
+	#undef FAMILY
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,143 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//The graph the programs search, read in from a text file or generated as two
+//cycles joined by a certain number of vertices, shared by every program so
+//they all read and number the edges the same way.
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Struct for a graph, holding the number of vertices, edges, and the
+//adjacency matrix for the graph
+struct Graph {
+	int vertices;
+	int edges;
+	int** graph;
+};
+
+struct Graph readGraph(char* filename);
+struct Graph generateGraph(int cycleSize, int connectingVertices);
+void printArr(int arr[], int size, int newline);
+
+/**
+ * Read in a graph from a given text file.
+ * The first line should contain the number of vertices in the graph.
+ * Then the file should contain the adjacency matrix of the graph.
+ * @param filename The name of the file containing the graph data
+ * @return A struct of the number of vertices, edges, and the adjacency matrix
+ */
+struct Graph readGraph(char* filename) {
+	FILE *file;
+	file = fopen(filename, "r");
+
+	int vertices;
+	int edges = 0;
+
+	//First line of input file is number of vertices
+	int result = fscanf(file, "%d\n", &vertices);
+	if (result != 1) {
+		printf("An error occured getting graph size from input file.\n");
+		exit(1);
+	}
+
+	//Init adjacency matrix
+	int** graph = (int **) malloc(vertices * sizeof(int *));
+
+	char* res;
+
+	//Loop over each vertex
+	for (int i1 = 0; i1 < vertices; i1++) {
+		graph[i1] = (int *) malloc(vertices * sizeof(int));
+
+		//Read in the line
+		char line[256]; //Hope this is big enough
+		res = fgets(line, sizeof(line), file);
+		if (res == NULL) {
+			printf("An error occured reading line from input file.\n");
+			exit(1);
+		}
+
+		//Split the line into each number
+		char* part = strtok(line, " ");
+		int c = 0;
+		while (part) {
+			char numC = part[0];
+			int num = numC - '0';
+			if (num == 0) {
+				graph[i1][c] = 0;
+			} else {
+				edges += num;
+				graph[i1][c] = edges;
+			}
+			part = strtok(NULL, " ");
+			c++;
+		}
+	}
+
+	fclose(file);
+
+	struct Graph g;
+	g.vertices = vertices;
+	g.edges = edges;
+	g.graph = graph;
+
+	return g;
+}
+
+/**
+ * Generates a graph of two cycles connected by some vertices
+ * @param cycleSize The size of the cycles to be connected
+ * @param connectingVertices The number of vertices the cycles are connected by
+ * @return A struct of the number of vertices, edges, and the adjacency matrix
+ */
+struct Graph generateGraph(int cycleSize, int connectingVertices) {
+	//Calculate number of vertices and generate adjacency matrix
+	int vertices = 2 * cycleSize - connectingVertices;
+	int** graph = (int **) malloc(vertices * sizeof(int *));
+	for (int i1 = 0; i1 < vertices; i1++) {
+		graph[i1] = (int *) malloc(vertices * sizeof(int));
+		for (int i2 = 0; i2 < vertices; i2++) {
+			graph[i1][i2] = 0;
+		}
+	}
+
+	//Connect the vertices
+	graph[0][cycleSize - 1] = 1;
+	graph[cycleSize - connectingVertices][vertices - 1] = cycleSize - connectingVertices + 2;
+	int edges = 2;
+	for (int i1 = 1; i1 < vertices; i1++) {
+		if (i1 < cycleSize - connectingVertices + 1) {
+			graph[i1][i1 - 1] = i1 + 1;
+		} else {
+			graph[i1][i1 - 1] = i1 + 2;
+		}
+		edges++;
+	}
+
+	struct Graph g;
+	g.vertices = vertices;
+	g.edges = edges;
+	g.graph = graph;
+
+	return g;
+}
+
+void printArr(int arr[], int size, int newline) {
+	printf("{");
+	for (int i1 = 0; i1 < size; i1++) {
+		printf("%d", arr[i1]);
+		if (i1 != size - 1) {
+			printf(", ");
+		}
+	}
+	printf("}");
+	if (newline) {
+		printf("\n");
+	}
+}
+
+#endif
@@ -0,0 +1,151 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Incidence lists for the labeling slots of a graph. A labeling is stored as a
+//permutation where slots 0 to vertices - 1 hold the vertex labels and slot
+//vertices + edge - 1 holds the label of the edge numbered edge in the
+//adjacency matrix. The value of a vertex is its own label, plus the labels of
+//the edges coming in, minus the labels of the edges going out.
+//
+//Each vertex only has a few edges, so the lists are compiled once from the
+//adjacency matrix into small integers in one cache line aligned block, and
+//every engine works from them instead of scanning rows and columns of the
+//matrix.
+
+#ifndef INCIDENCE_H
+#define INCIDENCE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INCIDENCE_ALIGN 64
+
+//Struct for the incidence of a graph. The slots that make up the value of
+//vertex v are slot[start[v]] to slot[start[v + 1] - 1]: its own slot first,
+//then the edges in, which are added, from minusStart[v] on the edges out,
+//which are subtracted. sign holds the same +1 or -1 for each entry.
+struct Incidence {
+	int vertices;
+	int edges;
+	int permSize;
+	unsigned char* start;
+	unsigned char* minusStart;
+	unsigned char* slot;
+	signed char* sign;
+
+	//The block all the lists are in
+	void* memory;
+};
+
+struct Incidence buildIncidence(int vertices, int edges, int** matrix);
+int vertexValue(const struct Incidence* inc, const int* labels, int vertex);
+int checkLabeling(const struct Incidence* inc, const int* labels, int* magicNumber);
+void freeIncidence(struct Incidence* inc);
+
+/**
+ * Build the incidence lists of a graph from its adjacency matrix
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix, holding the edge number or 0
+ * @return A struct of the incidence lists for each vertex
+ */
+struct Incidence buildIncidence(int vertices, int edges, int** matrix) {
+	struct Incidence inc;
+	inc.vertices = vertices;
+	inc.edges = edges;
+	inc.permSize = vertices + edges;
+
+	//Every vertex has its own slot, and every edge is in two lists
+	int size = vertices + 2 * edges;
+	if (size > 255) {
+		printf("The graph is too large for the incidence lists.\n");
+		exit(1);
+	}
+
+	//All the lists go in one block, rounded up to whole cache lines
+	int bytes = (vertices + 1) + vertices + 2 * size;
+	bytes = (bytes + INCIDENCE_ALIGN - 1) / INCIDENCE_ALIGN * INCIDENCE_ALIGN;
+	inc.memory = aligned_alloc(INCIDENCE_ALIGN, bytes);
+	inc.start = (unsigned char *) inc.memory;
+	inc.minusStart = inc.start + vertices + 1;
+	inc.slot = inc.minusStart + vertices;
+	inc.sign = (signed char *) (inc.slot + size);
+
+	int count = 0;
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		inc.start[vertex] = count;
+		inc.slot[count] = vertex;
+		inc.sign[count] = 1;
+		count++;
+
+		//Edges in are added
+		for (int vertexIn = 0; vertexIn < vertices; vertexIn++) {
+			int edge = matrix[vertexIn][vertex];
+			if (edge && count < size) {
+				inc.slot[count] = vertices + edge - 1;
+				inc.sign[count] = 1;
+				count++;
+			}
+		}
+
+		//Edges out are subtracted
+		inc.minusStart[vertex] = count;
+		for (int vertexOut = 0; vertexOut < vertices; vertexOut++) {
+			int edge = matrix[vertex][vertexOut];
+			if (edge && count < size) {
+				inc.slot[count] = vertices + edge - 1;
+				inc.sign[count] = -1;
+				count++;
+			}
+		}
+	}
+	inc.start[vertices] = count;
+
+	return inc;
+}
+
+/**
+ * Work out the value of a vertex from a labeling
+ * @param inc The incidence of the graph
+ * @param labels The label of each slot
+ * @param vertex The vertex to find the value of
+ * @return The value of the vertex
+ */
+int vertexValue(const struct Incidence* inc, const int* labels, int vertex) {
+	int value = 0;
+	for (int i1 = inc->start[vertex]; i1 < inc->minusStart[vertex]; i1++) {
+		value += labels[inc->slot[i1]];
+	}
+	for (int i1 = inc->minusStart[vertex]; i1 < inc->start[vertex + 1]; i1++) {
+		value -= labels[inc->slot[i1]];
+	}
+	return value;
+}
+
+/**
+ * Check if a labeling is magic. The first vertex sets the magic number and
+ * the check stops at the first vertex that misses it.
+ * @param inc The incidence of the graph
+ * @param labels The label of each slot
+ * @param magicNumber Set to the value of the first vertex
+ * @return The first vertex that misses the magic number, or -1 if the
+ *         labeling is magic
+ */
+int checkLabeling(const struct Incidence* inc, const int* labels, int* magicNumber) {
+	*magicNumber = vertexValue(inc, labels, 0);
+	for (int vertex = 1; vertex < inc->vertices; vertex++) {
+		if (vertexValue(inc, labels, vertex) != *magicNumber) {
+			return vertex;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Free the lists of an incidence struct
+ * @param inc The incidence to free
+ */
+void freeIncidence(struct Incidence* inc) {
+	free(inc->memory);
+}
+
+#endif
@@ -0,0 +1,118 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Incremental vertex values for the brute force loop. Consecutive permutations
+//share a prefix, and only the positions after it change, so instead of adding
+//up every vertex from the matrix each time, the value of every vertex is kept
+//and only the positions that changed are applied to it. A copy of the last
+//permutation is kept so the change at each position is known.
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdlib.h>
+
+#include "incidence.h"
+#include "prefix_skip.h"
+
+//Struct for the vertex values kept up to date as the permutation changes
+struct IncrementalEval {
+	int vertices;
+	int permSize;
+
+	//Vertices touched by each position of the permutation, and the sign
+	int* touchStart;
+	int* touchVertex;
+	int* touchSign;
+
+	//The permutation the values were last updated for, and the values
+	int* previous;
+	int* values;
+};
+
+struct IncrementalEval createIncrementalEval(int vertices, int edges, int** matrix,
+	struct PrefixSkip* ps, const int* permutation);
+void updateIncrementalEval(struct IncrementalEval* ie, const int* permutation, int from);
+void freeIncrementalEval(struct IncrementalEval* ie);
+
+/**
+ * Set up the vertex values for the first permutation of a loop
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param ps The prefix skipping struct of the loop, for the slot positions
+ * @param permutation The first permutation of the loop
+ * @return A struct of the vertex values, freed with freeIncrementalEval
+ */
+struct IncrementalEval createIncrementalEval(int vertices, int edges, int** matrix,
+	struct PrefixSkip* ps, const int* permutation) {
+	struct IncrementalEval ie;
+	int permSize = vertices + edges;
+	ie.vertices = vertices;
+	ie.permSize = permSize;
+
+	struct Incidence inc = buildIncidence(vertices, edges, matrix);
+	int incSize = inc.start[vertices];
+
+	//Invert the incidence lists so each position knows the vertices it touches
+	ie.touchStart = (int *) calloc(permSize + 1, sizeof(int));
+	ie.touchVertex = (int *) malloc(incSize * sizeof(int));
+	ie.touchSign = (int *) malloc(incSize * sizeof(int));
+	for (int i1 = 0; i1 < incSize; i1++) {
+		ie.touchStart[ps->position[inc.slot[i1]] + 1]++;
+	}
+	int touchCount[permSize];
+	for (int pos = 0; pos < permSize; pos++) {
+		ie.touchStart[pos + 1] += ie.touchStart[pos];
+		touchCount[pos] = ie.touchStart[pos];
+	}
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		for (int i1 = inc.start[vertex]; i1 < inc.start[vertex + 1]; i1++) {
+			int pos = ps->position[inc.slot[i1]];
+			ie.touchVertex[touchCount[pos]] = vertex;
+			ie.touchSign[touchCount[pos]] = inc.sign[i1];
+			touchCount[pos]++;
+		}
+	}
+
+	freeIncidence(&inc);
+
+	//Start from nothing assigned and apply the whole permutation
+	ie.previous = (int *) calloc(permSize, sizeof(int));
+	ie.values = (int *) calloc(vertices, sizeof(int));
+	updateIncrementalEval(&ie, permutation, 0);
+
+	return ie;
+}
+
+/**
+ * Bring the vertex values up to date after the permutation changed
+ * @param ie The vertex values
+ * @param permutation The new permutation
+ * @param from The first position that may have changed
+ */
+void updateIncrementalEval(struct IncrementalEval* ie, const int* permutation, int from) {
+	for (int pos = from; pos < ie->permSize; pos++) {
+		int change = permutation[pos] - ie->previous[pos];
+		if (change == 0) {
+			continue;
+		}
+		ie->previous[pos] = permutation[pos];
+		for (int i1 = ie->touchStart[pos]; i1 < ie->touchStart[pos + 1]; i1++) {
+			ie->values[ie->touchVertex[i1]] += ie->touchSign[i1] * change;
+		}
+	}
+}
+
+/**
+ * Free the arrays of the vertex values
+ * @param ie The struct to free
+ */
+void freeIncrementalEval(struct IncrementalEval* ie) {
+	free(ie->touchStart);
+	free(ie->touchVertex);
+	free(ie->touchSign);
+	free(ie->previous);
+	free(ie->values);
+}
+
+#endif
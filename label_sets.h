@@ -0,0 +1,200 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Label set first search for subtractive vertex magic labelings. Adding up the
+//values of all the vertices, every edge label is added once at the vertex it
+//goes into and subtracted once at the vertex it comes out of, so
+//
+//    vertices * k = sum of the vertex labels
+//
+//Any set of vertex labels whose sum is not a multiple of the number of
+//vertices cannot be part of a magic labeling, and the sets that are left each
+//fix the magic number.
+//
+//The sets of vertex labels are gone through in revolving door order, where
+//each set differs from the one before by swapping one label in and one label
+//out, so the sum is kept up to date in constant time. Each set that passes is
+//handed to the backtracking search with its vertex slots limited to the set,
+//its edge slots limited to the other labels, and the magic number fixed.
+//
+//The work is split into units by the rank of the set in revolving door order,
+//so the OpenMP and MPI programs can hand out sets the same way they hand out
+//permutation indexes. Labelings are not found in index order.
+
+#ifndef LABEL_SETS_H
+#define LABEL_SETS_H
+
+#include <stdlib.h>
+#include <vector>
+
+#include "automorphism.h"
+#include "backtrack.h"
+#include "magic_range.h"
+#include "results.h"
+
+long labelSetUnits(int vertices, int edges);
+void labelSetRange(int vertices, int edges, int** matrix, struct Symmetry* symmetry,
+	struct MagicRange magic, long unitStart, long unitEnd, struct Results* results);
+void unrankRevolvingDoor(long rank, int n, int t, int* combination);
+int nextRevolvingDoor(int* combination, int t);
+long binomial(int n, int t);
+
+/**
+ * The number of units of work, one for each set of vertex labels
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @return The number of units
+ */
+long labelSetUnits(int vertices, int edges) {
+	return binomial(vertices + edges, vertices);
+}
+
+/**
+ * Find every labeling whose set of vertex labels has a revolving door rank in
+ * [unitStart, unitEnd). The index and magic number of each labeling found are
+ * added to the results, not in index order.
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param symmetry The automorphisms of the graph to only find the smallest
+ *                 labeling of each orbit, or NULL to find every labeling
+ * @param magic The magic numbers to search for, sets that give any other
+ *              magic number are skipped
+ * @param unitStart The rank of the first set to search
+ * @param unitEnd One past the rank of the last set to search
+ * @param results The results to add the labelings found to
+ */
+void labelSetRange(int vertices, int edges, int** matrix, struct Symmetry* symmetry,
+	struct MagicRange magic, long unitStart, long unitEnd, struct Results* results) {
+	if (unitStart >= unitEnd) {
+		return;
+	}
+
+	int permSize = vertices + edges;
+	struct Backtracker bt = createBacktracker(vertices, edges, matrix, symmetry);
+	bt.magicFixed = 1;
+	PermIndex numPermutations = bt.blockSize[0] * permSize;
+
+	//Labels are one more than the elements of the combination
+	int combination[vertices + 1];
+	unrankRevolvingDoor(unitStart, permSize, vertices, combination);
+	int sum = vertices;
+	for (int i1 = 0; i1 < vertices; i1++) {
+		sum += combination[i1];
+	}
+
+	for (long unit = unitStart; unit < unitEnd && !searchStopped(results); unit++) {
+		if (sum % vertices == 0 && inMagicRange(magic, sum / vertices)) {
+			bt.vertexLabels = 0;
+			for (int i1 = 0; i1 < vertices; i1++) {
+				bt.vertexLabels |= 1ULL << combination[i1];
+			}
+			bt.edgeLabels = ~bt.vertexLabels;
+			bt.magicNumber = sum / vertices;
+			backtrackRange(&bt, 0, numPermutations, results);
+		}
+
+		if (unit + 1 < unitEnd) {
+			sum += nextRevolvingDoor(combination, vertices);
+		}
+	}
+
+	freeBacktracker(&bt);
+}
+
+/**
+ * Find the combination with a given rank in revolving door order. The order
+ * lists the combinations without n - 1 first, then the ones with n - 1 with
+ * the rest in reverse order.
+ * @param rank The rank of the combination
+ * @param n The number of elements to choose from
+ * @param t The number of elements to choose
+ * @param combination Array of t + 1 to hold the elements in increasing order,
+ *                    with n after them
+ */
+void unrankRevolvingDoor(long rank, int n, int t, int* combination) {
+	combination[t] = n;
+	while (t > 0) {
+		if (t == n) {
+			for (int i1 = 0; i1 < t; i1++) {
+				combination[i1] = i1;
+			}
+			return;
+		}
+
+		long without = binomial(n - 1, t);
+		if (rank >= without) {
+			combination[t - 1] = n - 1;
+			rank = binomial(n - 1, t - 1) - 1 - (rank - without);
+			t--;
+		}
+		n--;
+	}
+}
+
+/**
+ * Move to the next combination in revolving door order, Knuth's Algorithm R
+ * @param combination The elements of the current combination in increasing
+ *                    order, with the number of elements to choose
+ *                    from after them, changed in place
+ * @param t The number of elements to choose
+ * @return The change in the sum of the elements
+ */
+int nextRevolvingDoor(int* combination, int t) {
+	int* c = combination;
+
+	//The first element can move on its own
+	if (t % 2 == 1) {
+		if (c[0] + 1 < c[1]) {
+			c[0]++;
+			return 1;
+		}
+	} else if (c[0] > 0) {
+		c[0]--;
+		return -1;
+	}
+
+	//Otherwise find the first element that can move, with the elements
+	//before it packed at the bottom. Using j as a 1 based index, c[j - 1] can
+	//go down when it sits right after the one before it, or up when the one
+	//before it is as low as it can go.
+	int j = 2;
+	int down = t % 2 == 1;
+	while (j <= t) {
+		if (down) {
+			if (c[j - 1] >= j) {
+				int removed = c[j - 1];
+				c[j - 1] = c[j - 2];
+				c[j - 2] = j - 2;
+				return c[j - 2] - removed;
+			}
+		} else if (c[j - 1] + 1 < c[j]) {
+			int added = c[j - 1] + 1;
+			c[j - 2] = c[j - 1];
+			c[j - 1] = added;
+			return added - (j - 2);
+		}
+		j++;
+		down = !down;
+	}
+
+	return 0;
+}
+
+/**
+ * The number of ways to choose t of n elements
+ * @param n The number of elements to choose from
+ * @param t The number of elements to choose
+ * @return n choose t
+ */
+long binomial(int n, int t) {
+	if (t < 0 || t > n) {
+		return 0;
+	}
+	long result = 1;
+	for (int i1 = 1; i1 <= t; i1++) {
+		result = result * (n - t + i1) / i1;
+	}
+	return result;
+}
+
+#endif
@@ -0,0 +1,113 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Bounds on the magic number of a graph, worked out before any search. Adding
+//up the values of all the vertices, every edge label is added once and
+//subtracted once, so
+//
+//    vertices * k = sum of the vertex labels
+//
+//and k is at least the average of the smallest vertices labels and at most the
+//average of the largest. Each vertex also bounds k on its own: its value is
+//its own label plus the labels of its in edges, all different, minus the
+//labels of its out edges, so it is at least the smallest of those labels minus
+//the largest, and at most the other way around. The magic number has to be in
+//every one of these ranges.
+//
+//A search can be limited to a range of magic numbers with --magic. The
+//backtracking search then splits its work by magic number as well as by
+//permutation index, so each part of the work searches with the magic number
+//fixed from the start: unit u is index u % numPermutations with magic number
+//low + u / numPermutations.
+
+#ifndef MAGIC_RANGE_H
+#define MAGIC_RANGE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "incidence.h"
+
+//Struct for a range of magic numbers, from low to high inclusive
+struct MagicRange {
+	int low;
+	int high;
+};
+
+struct MagicRange feasibleMagicRange(int vertices, int edges, int** matrix);
+struct MagicRange intersectMagicRange(struct MagicRange a, struct MagicRange b);
+int magicRangeSize(struct MagicRange magic);
+int inMagicRange(struct MagicRange magic, int magicNumber);
+int labelSum(int first, int count);
+
+/**
+ * Work out the range of magic numbers a labeling of a graph could have
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @return The range, which is empty if no labeling is possible
+ */
+struct MagicRange feasibleMagicRange(int vertices, int edges, int** matrix) {
+	int permSize = vertices + edges;
+	struct MagicRange magic;
+
+	//The average of the vertex labels, rounded in
+	magic.low = (labelSum(1, vertices) + vertices - 1) / vertices;
+	magic.high = labelSum(permSize - vertices + 1, vertices) / vertices;
+
+	struct Incidence inc = buildIncidence(vertices, edges, matrix);
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		int plus = inc.minusStart[vertex] - inc.start[vertex];
+		int minus = inc.start[vertex + 1] - inc.minusStart[vertex];
+		struct MagicRange bound;
+		bound.low = labelSum(1, plus) - labelSum(permSize - minus + 1, minus);
+		bound.high = labelSum(permSize - plus + 1, plus) - labelSum(1, minus);
+		magic = intersectMagicRange(magic, bound);
+	}
+	freeIncidence(&inc);
+
+	return magic;
+}
+
+/**
+ * Find the magic numbers in both of two ranges
+ * @param a The first range
+ * @param b The second range
+ * @return The range of magic numbers in both
+ */
+struct MagicRange intersectMagicRange(struct MagicRange a, struct MagicRange b) {
+	struct MagicRange magic;
+	magic.low = a.low > b.low ? a.low : b.low;
+	magic.high = a.high < b.high ? a.high : b.high;
+	return magic;
+}
+
+/**
+ * The number of magic numbers in a range
+ * @param magic The range
+ * @return The number of magic numbers, 0 if the range is empty
+ */
+int magicRangeSize(struct MagicRange magic) {
+	return magic.high >= magic.low ? magic.high - magic.low + 1 : 0;
+}
+
+/**
+ * Check if a magic number is in a range
+ * @param magic The range
+ * @param magicNumber The magic number
+ * @return 1 if it is in the range, 0 if not
+ */
+inline int inMagicRange(struct MagicRange magic, int magicNumber) {
+	return magicNumber >= magic.low && magicNumber <= magic.high;
+}
+
+/**
+ * Add up a run of consecutive labels
+ * @param first The first label
+ * @param count How many labels
+ * @return first + (first + 1) + ... + (first + count - 1)
+ */
+int labelSum(int first, int count) {
+	return count * (2 * first + count - 1) / 2;
+}
+
+#endif
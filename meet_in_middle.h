@@ -0,0 +1,661 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Meet in the middle search for subtractive vertex magic labelings. The
+//vertices are split into two sides. For the graphs from generateGraph the low
+//numbered vertices are the left cycle and the high numbered ones the right
+//cycle, with the connecting path in the middle, so splitting by vertex number
+//puts one cycle on each side and cuts across the path.
+//
+//Side A labels its vertices, the edges inside it, and the edges that cross to
+//side B. Every vertex on side A then has its full value, which has to be the
+//magic number k. The crossing edges also add to or take away from the values
+//of the vertices on side B they touch, the boundary vertices. Side B labels
+//its vertices and the edges inside it. Its vertices without crossing edges
+//have to reach k on their own, and each boundary vertex needs the crossing
+//edges to make up the difference.
+//
+//For each k both sides are searched separately, and each partial labeling is
+//keyed by the labels it used and the boundary sums it gives or needs. Two
+//partial labelings join into a full one when their labels are complements and
+//their boundary sums match, which is found with a hash join. The records are
+//spread over partitions by hash, and when they take up more memory than
+//allowed the partitions are spilled to temporary files and joined one at a
+//time. Each partition is joined a piece of side A at a time, with the piece
+//and its hash table in half the memory allowed and side B read through in
+//blocks that fit in the other half, so a large partition never has to fit in
+//memory whole.
+//
+//The work is split into units by magic number, one for each magic number in
+//the range from magic_range.h, so the OpenMP and MPI programs can hand out
+//magic numbers the same way they hand out permutation indexes.
+//Labelings are not found in index order.
+
+#ifndef MEET_IN_MIDDLE_H
+#define MEET_IN_MIDDLE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+#include "incidence.h"
+#include "automorphism.h"
+#include "magic_range.h"
+#include "perm_rank.h"
+#include "results.h"
+
+#define MEET_PARTITIONS 64
+#define MEET_TABLE_ENTRY 64 //Bytes of hash table for each record of a piece of side A
+#define MEET_SIDE_A 0
+#define MEET_SIDE_B 1
+
+//Struct for one side of the search: the slots it labels, the vertices each
+//slot touches, and the vertices that have to reach the magic number
+struct MeetSide {
+	int numSlots;
+	int* slots;
+
+	//Vertices touched by the slot at each depth, and the sign
+	int* touchStart;
+	int* touchVertex;
+	int* touchSign;
+
+	//Vertices with all their slots assigned at each depth
+	int* closeStart;
+	int* closeVertex;
+
+	//Size in bytes of a record: label mask, boundary sums, slot labels
+	int recordSize;
+};
+
+//Struct for the meet in the middle search
+struct MeetSearch {
+	struct Incidence inc;
+	int vertices;
+	int edges;
+	int permSize;
+	struct MeetSide sides[2];
+
+	//Vertices on side B touched by crossing edges
+	int numBoundary;
+	int* boundary;
+
+	//Range of possible magic numbers, one unit of work each
+	int kLow;
+	int kHigh;
+
+	//Memory for records before the partitions are spilled to disk
+	long memoryLimit;
+
+	//The automorphisms of the graph, or NULL to keep every labeling
+	struct Symmetry* symmetry;
+
+	//Search state
+	int side;
+	int k;
+	int* labels;
+	int* partial;
+	int* plusLeft;
+	int* minusLeft;
+	unsigned long long freeLabels;
+	std::vector<unsigned char> buffers[2][MEET_PARTITIONS];
+	FILE* files[2][MEET_PARTITIONS];
+	long bufferedBytes;
+	int spilled;
+	struct Results* results;
+};
+
+struct MeetSearch createMeetSearch(int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry, struct MagicRange magic, long memoryLimit);
+long meetSearchUnits(struct MagicRange magic);
+void meetSearchRange(struct MeetSearch* ms, long unitStart, long unitEnd,
+	struct Results* results);
+void freeMeetSearch(struct MeetSearch* ms);
+void buildMeetSide(struct MeetSearch* ms, struct MeetSide* side, int* onSide, int* checked);
+void meetSideSearch(struct MeetSearch* ms, int depth);
+void meetEmitRecord(struct MeetSearch* ms);
+void meetSpill(struct MeetSearch* ms);
+void meetJoinPartition(struct MeetSearch* ms, int partition);
+long meetPartitionRecords(struct MeetSearch* ms, int side, int partition);
+const unsigned char* meetReadRecords(struct MeetSearch* ms, int side, int partition, long first, long* count,
+	std::vector<unsigned char>& block);
+unsigned long long meetHashKey(const unsigned char* record, int keySize);
+
+/**
+ * Set up a meet in the middle search for a graph
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param symmetry The automorphisms of the graph to only keep the smallest
+ *                 labeling of each orbit, or NULL to keep every labeling
+ * @param magic The magic numbers to search for, one unit each
+ * @param memoryLimit Bytes of records to hold before spilling to disk
+ * @return A struct for the search, freed with freeMeetSearch
+ */
+struct MeetSearch createMeetSearch(int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry, struct MagicRange magic, long memoryLimit) {
+	struct MeetSearch ms;
+	ms.inc = buildIncidence(vertices, edges, matrix);
+	ms.vertices = vertices;
+	ms.edges = edges;
+	ms.permSize = vertices + edges;
+	ms.symmetry = symmetry;
+	ms.memoryLimit = memoryLimit;
+
+	if (ms.permSize > 64) {
+		printf("The meet in the middle engine supports at most 64 labels.\n");
+		exit(1);
+	}
+
+	int permSize = ms.permSize;
+	struct Incidence* inc = &ms.inc;
+
+	//Split the vertices by number, the first half is side A
+	int sideA = vertices / 2;
+	int vertexSide[vertices];
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		vertexSide[vertex] = vertex < sideA ? MEET_SIDE_A : MEET_SIDE_B;
+	}
+
+	//Vertex slots go with their vertex. Edges inside side B go to side B, and
+	//every other edge, including the crossing ones, goes to side A.
+	int slotSide[permSize];
+	for (int slot = 0; slot < permSize; slot++) {
+		slotSide[slot] = slot < vertices ? vertexSide[slot] : MEET_SIDE_A;
+	}
+	for (int i1 = 0; i1 < vertices; i1++) {
+		for (int i2 = 0; i2 < vertices; i2++) {
+			int edge = matrix[i1][i2];
+			if (edge && vertexSide[i1] == MEET_SIDE_B && vertexSide[i2] == MEET_SIDE_B) {
+				slotSide[vertices + edge - 1] = MEET_SIDE_B;
+			}
+		}
+	}
+
+	//Boundary vertices are on side B but have a slot on side A
+	ms.boundary = (int *) malloc(vertices * sizeof(int));
+	ms.numBoundary = 0;
+	int checked[2][vertices];
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		int onA = 0;
+		for (int i1 = inc->start[vertex]; i1 < inc->start[vertex + 1]; i1++) {
+			onA |= slotSide[inc->slot[i1]] == MEET_SIDE_A;
+		}
+		checked[MEET_SIDE_A][vertex] = vertexSide[vertex] == MEET_SIDE_A;
+		checked[MEET_SIDE_B][vertex] = vertexSide[vertex] == MEET_SIDE_B && !onA;
+		if (vertexSide[vertex] == MEET_SIDE_B && onA) {
+			ms.boundary[ms.numBoundary++] = vertex;
+		}
+	}
+
+	for (int side = 0; side < 2; side++) {
+		int onSide[permSize];
+		for (int slot = 0; slot < permSize; slot++) {
+			onSide[slot] = slotSide[slot] == side;
+		}
+		buildMeetSide(&ms, &ms.sides[side], onSide, checked[side]);
+	}
+
+	//The first unit is the smallest magic number
+	ms.kLow = magic.low;
+	ms.kHigh = magic.high;
+
+	ms.labels = (int *) malloc(permSize * sizeof(int));
+	ms.partial = (int *) malloc(vertices * sizeof(int));
+	ms.plusLeft = (int *) malloc(vertices * sizeof(int));
+	ms.minusLeft = (int *) malloc(vertices * sizeof(int));
+	for (int side = 0; side < 2; side++) {
+		for (int partition = 0; partition < MEET_PARTITIONS; partition++) {
+			ms.files[side][partition] = NULL;
+		}
+	}
+	ms.results = NULL;
+
+	return ms;
+}
+
+/**
+ * Work out the slot order and the touch and close lists of one side
+ * @param ms The search
+ * @param side The side to fill in
+ * @param onSide Whether each slot is labeled by this side
+ * @param checked Whether each vertex has to reach the magic number on this side
+ */
+void buildMeetSide(struct MeetSearch* ms, struct MeetSide* side, int* onSide, int* checked) {
+	struct Incidence* inc = &ms->inc;
+	int vertices = ms->vertices;
+	int permSize = ms->permSize;
+
+	//Vertex slots first, then edges, in slot order
+	side->slots = (int *) malloc(permSize * sizeof(int));
+	side->numSlots = 0;
+	int depthOf[permSize];
+	for (int slot = 0; slot < permSize; slot++) {
+		depthOf[slot] = -1;
+		if (onSide[slot]) {
+			depthOf[slot] = side->numSlots;
+			side->slots[side->numSlots++] = slot;
+		}
+	}
+	int numSlots = side->numSlots;
+
+	side->touchStart = (int *) calloc(numSlots + 1, sizeof(int));
+	side->touchVertex = (int *) malloc(inc->start[vertices] * sizeof(int));
+	side->touchSign = (int *) malloc(inc->start[vertices] * sizeof(int));
+	side->closeStart = (int *) calloc(numSlots + 1, sizeof(int));
+	side->closeVertex = (int *) malloc(vertices * sizeof(int));
+
+	int closeDepth[vertices];
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		closeDepth[vertex] = -1;
+		for (int i1 = inc->start[vertex]; i1 < inc->start[vertex + 1]; i1++) {
+			int depth = depthOf[inc->slot[i1]];
+			if (depth >= 0) {
+				side->touchStart[depth + 1]++;
+				if (depth > closeDepth[vertex]) {
+					closeDepth[vertex] = depth;
+				}
+			}
+		}
+		if (checked[vertex]) {
+			side->closeStart[closeDepth[vertex] + 1]++;
+		}
+	}
+	for (int depth = 0; depth < numSlots; depth++) {
+		side->touchStart[depth + 1] += side->touchStart[depth];
+		side->closeStart[depth + 1] += side->closeStart[depth];
+	}
+
+	int touchCount[numSlots + 1];
+	int closeCount[numSlots + 1];
+	for (int depth = 0; depth <= numSlots; depth++) {
+		touchCount[depth] = side->touchStart[depth];
+		closeCount[depth] = side->closeStart[depth];
+	}
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		for (int i1 = inc->start[vertex]; i1 < inc->start[vertex + 1]; i1++) {
+			int depth = depthOf[inc->slot[i1]];
+			if (depth >= 0) {
+				side->touchVertex[touchCount[depth]] = vertex;
+				side->touchSign[touchCount[depth]] = inc->sign[i1];
+				touchCount[depth]++;
+			}
+		}
+		if (checked[vertex]) {
+			side->closeVertex[closeCount[closeDepth[vertex]]++] = vertex;
+		}
+	}
+
+	side->recordSize = sizeof(unsigned long long) + ms->numBoundary * sizeof(short) + numSlots;
+}
+
+/**
+ * The number of units of work, one for each magic number to search for
+ * @param magic The magic numbers to search for
+ * @return The number of units
+ */
+long meetSearchUnits(struct MagicRange magic) {
+	return magicRangeSize(magic);
+}
+
+/**
+ * Find every labeling whose magic number is in the units [unitStart, unitEnd).
+ * The index and magic number of each labeling found are added to the results,
+ * not in index order.
+ * @param ms The search to run
+ * @param unitStart The first unit to search
+ * @param unitEnd One past the last unit to search
+ * @param results The results to add the labelings found to
+ */
+void meetSearchRange(struct MeetSearch* ms, long unitStart, long unitEnd,
+	struct Results* results) {
+	ms->results = results;
+
+	for (long unit = unitStart; unit < unitEnd && !searchStopped(results); unit++) {
+		ms->k = ms->kLow + unit;
+		ms->bufferedBytes = 0;
+		ms->spilled = 0;
+
+		//Search both sides for this magic number, filling the partitions
+		for (int side = 0; side < 2; side++) {
+			ms->side = side;
+			ms->freeLabels = ms->permSize == 64 ? ~0ULL : (1ULL << ms->permSize) - 1;
+			for (int vertex = 0; vertex < ms->vertices; vertex++) {
+				ms->partial[vertex] = 0;
+				ms->plusLeft[vertex] = 0;
+				ms->minusLeft[vertex] = 0;
+			}
+			struct MeetSide* meetSide = &ms->sides[side];
+			for (int i1 = 0; i1 < meetSide->touchStart[meetSide->numSlots]; i1++) {
+				if (meetSide->touchSign[i1] > 0) {
+					ms->plusLeft[meetSide->touchVertex[i1]]++;
+				} else {
+					ms->minusLeft[meetSide->touchVertex[i1]]++;
+				}
+			}
+			meetSideSearch(ms, 0);
+		}
+
+		//The join reads pieces of records into the other half of the memory,
+		//so once anything is on disk, or the buffers take more than half,
+		//everything goes to disk
+		if (ms->spilled || ms->bufferedBytes > ms->memoryLimit / 2) {
+			meetSpill(ms);
+		}
+		for (int partition = 0; partition < MEET_PARTITIONS; partition++) {
+			meetJoinPartition(ms, partition);
+		}
+
+		//Start the next magic number with empty partitions
+		for (int side = 0; side < 2; side++) {
+			for (int partition = 0; partition < MEET_PARTITIONS; partition++) {
+				ms->buffers[side][partition].clear();
+				if (ms->files[side][partition] != NULL) {
+					fclose(ms->files[side][partition]);
+					ms->files[side][partition] = NULL;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Label the slots of the current side from the given depth on, checking the
+ * vertices that have to reach the magic number as they close
+ * @param ms The search
+ * @param depth The slot of the side to label
+ */
+void meetSideSearch(struct MeetSearch* ms, int depth) {
+	struct MeetSide* side = &ms->sides[ms->side];
+	if (depth == side->numSlots) {
+		meetEmitRecord(ms);
+		return;
+	}
+	if (searchStopped(ms->results)) {
+		return;
+	}
+
+	int slot = side->slots[depth];
+	unsigned long long candidates = ms->freeLabels;
+	while (candidates) {
+		int label = __builtin_ctzll(candidates) + 1;
+		candidates &= candidates - 1;
+
+		ms->labels[slot] = label;
+		ms->freeLabels &= ~(1ULL << (label - 1));
+		for (int i1 = side->touchStart[depth]; i1 < side->touchStart[depth + 1]; i1++) {
+			int vertex = side->touchVertex[i1];
+			if (side->touchSign[i1] > 0) {
+				ms->partial[vertex] += label;
+				ms->plusLeft[vertex]--;
+			} else {
+				ms->partial[vertex] -= label;
+				ms->minusLeft[vertex]--;
+			}
+		}
+
+		int works = 1;
+		for (int i1 = side->closeStart[depth]; i1 < side->closeStart[depth + 1]; i1++) {
+			if (ms->partial[side->closeVertex[i1]] != ms->k) {
+				works = 0;
+				break;
+			}
+		}
+
+		//Bound the checked vertices that are still open with the smallest
+		//and largest free labels
+		if (works && ms->freeLabels) {
+			int minFree = __builtin_ctzll(ms->freeLabels) + 1;
+			int maxFree = 64 - __builtin_clzll(ms->freeLabels);
+			for (int d = depth + 1; d < side->numSlots && works; d++) {
+				for (int i1 = side->closeStart[d]; i1 < side->closeStart[d + 1]; i1++) {
+					int vertex = side->closeVertex[i1];
+					int low = ms->partial[vertex] + ms->plusLeft[vertex] * minFree - ms->minusLeft[vertex] * maxFree;
+					int high = ms->partial[vertex] + ms->plusLeft[vertex] * maxFree - ms->minusLeft[vertex] * minFree;
+					if (ms->k < low || ms->k > high) {
+						works = 0;
+						break;
+					}
+				}
+			}
+		}
+
+		if (works) {
+			meetSideSearch(ms, depth + 1);
+		}
+
+		for (int i1 = side->touchStart[depth]; i1 < side->touchStart[depth + 1]; i1++) {
+			int vertex = side->touchVertex[i1];
+			if (side->touchSign[i1] > 0) {
+				ms->partial[vertex] -= label;
+				ms->plusLeft[vertex]++;
+			} else {
+				ms->partial[vertex] += label;
+				ms->minusLeft[vertex]++;
+			}
+		}
+		ms->freeLabels |= 1ULL << (label - 1);
+	}
+}
+
+/**
+ * Store the current partial labeling of a side in its partition. The key is
+ * the set of labels side A used, and the sums side A gives the boundary
+ * vertices, so side B stores the complement of its labels and the sums it
+ * still needs.
+ * @param ms The search
+ */
+void meetEmitRecord(struct MeetSearch* ms) {
+	struct MeetSide* side = &ms->sides[ms->side];
+	unsigned char record[side->recordSize];
+
+	unsigned long long all = ms->permSize == 64 ? ~0ULL : (1ULL << ms->permSize) - 1;
+	unsigned long long mask = ms->side == MEET_SIDE_A ? all & ~ms->freeLabels : ms->freeLabels;
+	memcpy(record, &mask, sizeof(mask));
+
+	for (int i1 = 0; i1 < ms->numBoundary; i1++) {
+		int partial = ms->partial[ms->boundary[i1]];
+		short sum = ms->side == MEET_SIDE_A ? partial : ms->k - partial;
+		memcpy(record + sizeof(mask) + i1 * sizeof(short), &sum, sizeof(sum));
+	}
+
+	int keySize = sizeof(mask) + ms->numBoundary * sizeof(short);
+	for (int i1 = 0; i1 < side->numSlots; i1++) {
+		record[keySize + i1] = ms->labels[side->slots[i1]];
+	}
+
+	int partition = meetHashKey(record, keySize) % MEET_PARTITIONS;
+	std::vector<unsigned char>& buffer = ms->buffers[ms->side][partition];
+	buffer.insert(buffer.end(), record, record + side->recordSize);
+
+	ms->bufferedBytes += side->recordSize;
+	if (ms->bufferedBytes > ms->memoryLimit) {
+		meetSpill(ms);
+	}
+}
+
+/**
+ * Append every partition buffer to its temporary file and empty the buffers
+ * @param ms The search
+ */
+void meetSpill(struct MeetSearch* ms) {
+	for (int side = 0; side < 2; side++) {
+		for (int partition = 0; partition < MEET_PARTITIONS; partition++) {
+			std::vector<unsigned char>& buffer = ms->buffers[side][partition];
+			if (buffer.empty()) {
+				continue;
+			}
+			if (ms->files[side][partition] == NULL) {
+				ms->files[side][partition] = tmpfile();
+				if (ms->files[side][partition] == NULL) {
+					printf("An error occured creating a temporary file.\n");
+					exit(1);
+				}
+			}
+			fwrite(&buffer[0], 1, buffer.size(), ms->files[side][partition]);
+			buffer.clear();
+			buffer.shrink_to_fit();
+		}
+	}
+	ms->bufferedBytes = 0;
+	ms->spilled = 1;
+}
+
+/**
+ * Count the records of one side of a partition, which are all in its file
+ * once it has been spilled and all in its buffer if not
+ * @param ms The search
+ * @param side The side to count
+ * @param partition The partition to count
+ * @return The number of records
+ */
+long meetPartitionRecords(struct MeetSearch* ms, int side, int partition) {
+	FILE* file = ms->files[side][partition];
+	if (file == NULL) {
+		return ms->buffers[side][partition].size() / ms->sides[side].recordSize;
+	}
+	fseek(file, 0, SEEK_END);
+	return ftell(file) / ms->sides[side].recordSize;
+}
+
+/**
+ * Get a run of records of one side of a partition, read from its file into a
+ * block, or straight from its buffer if it was never spilled
+ * @param ms The search
+ * @param side The side to read
+ * @param partition The partition to read
+ * @param first The first record to read
+ * @param count How many records to read, set to how many there were
+ * @param block Vector to read the records into from the file
+ * @return The first record read
+ */
+const unsigned char* meetReadRecords(struct MeetSearch* ms, int side, int partition, long first, long* count,
+	std::vector<unsigned char>& block) {
+	int recordSize = ms->sides[side].recordSize;
+	long total = meetPartitionRecords(ms, side, partition);
+	if (*count > total - first) {
+		*count = total - first;
+	}
+
+	FILE* file = ms->files[side][partition];
+	if (file == NULL) {
+		return &ms->buffers[side][partition][first * recordSize];
+	}
+	block.resize(*count * recordSize);
+	fseek(file, first * recordSize, SEEK_SET);
+	if (fread(&block[0], recordSize, *count, file) != (size_t) *count) {
+		printf("An error occured reading a temporary file.\n");
+		exit(1);
+	}
+	return &block[0];
+}
+
+/**
+ * Join the records of both sides in one partition, and store the labelings
+ * that come out of it. Side A is taken a piece at a time, and for each piece
+ * side B is read through in blocks, so at most the memory limit is used.
+ * @param ms The search
+ * @param partition The partition to join
+ */
+void meetJoinPartition(struct MeetSearch* ms, int partition) {
+	struct MeetSide* sideA = &ms->sides[MEET_SIDE_A];
+	struct MeetSide* sideB = &ms->sides[MEET_SIDE_B];
+	int keySize = sizeof(unsigned long long) + ms->numBoundary * sizeof(short);
+
+	long countA = meetPartitionRecords(ms, MEET_SIDE_A, partition);
+	long countB = meetPartitionRecords(ms, MEET_SIDE_B, partition);
+	if (countA == 0 || countB == 0) {
+		return;
+	}
+
+	//A piece of side A and its hash table take half the memory, and a block
+	//of side B the other half
+	long pieceSize = ms->memoryLimit / 2 / (sideA->recordSize + MEET_TABLE_ENTRY);
+	long blockSize = ms->memoryLimit / 2 / sideB->recordSize;
+	pieceSize = pieceSize > 0 ? pieceSize : 1;
+	blockSize = blockSize > 0 ? blockSize : 1;
+
+	std::vector<unsigned char> pieceRecords;
+	std::vector<unsigned char> blockRecords;
+	std::unordered_multimap<unsigned long long, long> table;
+	for (long pieceStart = 0; pieceStart < countA && !searchStopped(ms->results); pieceStart += pieceSize) {
+		//Build the hash table on the piece of side A
+		long pieceCount = pieceSize;
+		const unsigned char* piece = meetReadRecords(ms, MEET_SIDE_A, partition, pieceStart, &pieceCount,
+			pieceRecords);
+		table.clear();
+		table.reserve(pieceCount);
+		for (long i1 = 0; i1 < pieceCount; i1++) {
+			table.insert(std::make_pair(meetHashKey(piece + i1 * sideA->recordSize, keySize), i1));
+		}
+
+		//Probe it with every block of side B
+		for (long blockStart = 0; blockStart < countB && !searchStopped(ms->results); blockStart += blockSize) {
+			long blockCount = blockSize;
+			const unsigned char* block = meetReadRecords(ms, MEET_SIDE_B, partition, blockStart, &blockCount,
+				blockRecords);
+			for (long i1 = 0; i1 < blockCount && !searchStopped(ms->results); i1++) {
+				const unsigned char* recordB = block + i1 * sideB->recordSize;
+				auto matches = table.equal_range(meetHashKey(recordB, keySize));
+				for (auto match = matches.first; match != matches.second; ++match) {
+					const unsigned char* recordA = piece + match->second * sideA->recordSize;
+					if (memcmp(recordA, recordB, keySize) != 0) {
+						continue;
+					}
+
+					for (int i2 = 0; i2 < sideA->numSlots; i2++) {
+						ms->labels[sideA->slots[i2]] = recordA[keySize + i2];
+					}
+					for (int i2 = 0; i2 < sideB->numSlots; i2++) {
+						ms->labels[sideB->slots[i2]] = recordB[keySize + i2];
+					}
+					if (ms->symmetry != NULL && !isCanonical(ms->symmetry, ms->labels)) {
+						continue;
+					}
+					addResult(ms->results, rankPermutation(ms->labels, ms->permSize), ms->k);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Hash the key of a record
+ * @param record The record, starting with its key
+ * @param keySize The number of bytes in the key
+ * @return The hash of the key
+ */
+unsigned long long meetHashKey(const unsigned char* record, int keySize) {
+	//FNV-1a
+	unsigned long long hash = 14695981039346656037ULL;
+	for (int i1 = 0; i1 < keySize; i1++) {
+		hash ^= record[i1];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/**
+ * Free the arrays of a meet in the middle search
+ * @param ms The search to free
+ */
+void freeMeetSearch(struct MeetSearch* ms) {
+	freeIncidence(&ms->inc);
+	for (int side = 0; side < 2; side++) {
+		struct MeetSide* meetSide = &ms->sides[side];
+		free(meetSide->slots);
+		free(meetSide->touchStart);
+		free(meetSide->touchVertex);
+		free(meetSide->touchSign);
+		free(meetSide->closeStart);
+		free(meetSide->closeVertex);
+	}
+	free(ms->boundary);
+	free(ms->labels);
+	free(ms->partial);
+	free(ms->plusLeft);
+	free(ms->minusLeft);
+}
+
+#endif
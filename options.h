@@ -0,0 +1,303 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Command line options shared by the sequential, OpenMP, and MPI programs.
+//
+//Usage:
+//    ./vertex_magic [cycleSize connectingVertices] [options]
+//
+//Options:
+//    --engine brute|backtrack|edge|mitm|labelset|sjt|simd
+//                                    Search engine to use (default backtrack)
+//    --graph filename                Read the graph from a file instead
+//    --reorder                       Reorder the slots in the brute force loop
+//                                    so vertices are closed as early as possible
+//    --symmetry                      Only find the smallest labeling of each
+//                                    orbit under the automorphisms of the graph
+//    --memory megabytes              Memory for the meet in the middle records
+//                                    of each process, shared by its threads,
+//                                    before they are spilled to disk (default 1024)
+//    --scalar                        Use the scalar path of the SIMD engine
+//    --codegen                       Generate and compile a check for the graph
+//                                    for the brute force loop
+//    --count                         Only count the labelings for each magic
+//                                    number instead of writing them out
+//    --first                         Stop after the first labeling found
+//    --limit count                   Stop after this many labelings are found
+//    --magic k|low:high              Only search for labelings with this magic
+//                                    number, or one in this range
+//    --stream                        MPI only: write out the labelings on a
+//                                    separate process while the search runs
+//    --format text|records|ranks     Write the labelings as text, or to a
+//                                    binary file of fixed size records or of
+//                                    compressed permutation indexes (default text)
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ENGINE_BRUTE 1 //Check every permutation with std::next_permutation
+#define ENGINE_BACKTRACK 2 //Assign one slot at a time and prune
+#define ENGINE_EDGE 3 //Label the edges and derive the vertex labels
+#define ENGINE_MITM 4 //Search the two halves of the graph and join them
+#define ENGINE_LABELSET 5 //Pick the vertex labels first, then backtrack
+#define ENGINE_SJT 6 //Check every permutation in plain changes order
+#define ENGINE_SIMD 7 //Check batches of permutations with vector instructions
+
+#define FORMAT_TEXT 0 //The text output file
+#define FORMAT_RECORDS 1 //Binary records, RESULT_RECORDS in result_file.h
+#define FORMAT_RANKS 2 //Binary permutation indexes, RESULT_RANKS in result_file.h
+
+//Struct for the command line options
+struct Options {
+	int cycleSize;
+	int connectingVertices;
+	int engine;
+	char* graphFile;
+	int reorderSlots;
+	int symmetry;
+	long memoryLimit;
+	int scalar;
+	int codegen;
+	int countOnly;
+	long limit;
+	int magicSet;
+	int magicLow;
+	int magicHigh;
+	int stream;
+	int format;
+};
+
+void printUsage(char* program);
+int resultsUnordered(struct Options* options);
+const char* graphFileName(struct Options* options);
+void outputFilename(struct Options* options, const char* extension, char* filename, int size);
+void outputGraphLine(struct Options* options, char* line, int size);
+
+/**
+ * Parse the command line options. The cycle size and number of connecting
+ * vertices are given as the first two plain arguments, anything starting with
+ * -- is an option.
+ * @param argc The number of arguments
+ * @param argv The arguments
+ * @return A struct of the parsed options
+ */
+struct Options parseOptions(int argc, char *argv[]) {
+	struct Options options;
+	options.cycleSize = 4;
+	options.connectingVertices = 2;
+	options.engine = ENGINE_BACKTRACK;
+	options.graphFile = NULL;
+	options.reorderSlots = 0;
+	options.symmetry = 0;
+	options.memoryLimit = 1024L * 1024 * 1024;
+	options.scalar = 0;
+	options.codegen = 0;
+	options.countOnly = 0;
+	options.limit = 0;
+	options.magicSet = 0;
+	options.magicLow = 0;
+	options.magicHigh = 0;
+	options.stream = 0;
+	options.format = FORMAT_TEXT;
+
+	int positional = 0;
+	for (int i1 = 1; i1 < argc; i1++) {
+		char* arg = argv[i1];
+		if (strcmp(arg, "--engine") == 0 && i1 + 1 < argc) {
+			char* engine = argv[++i1];
+			if (strcmp(engine, "brute") == 0) {
+				options.engine = ENGINE_BRUTE;
+			} else if (strcmp(engine, "backtrack") == 0) {
+				options.engine = ENGINE_BACKTRACK;
+			} else if (strcmp(engine, "edge") == 0) {
+				options.engine = ENGINE_EDGE;
+			} else if (strcmp(engine, "mitm") == 0) {
+				options.engine = ENGINE_MITM;
+			} else if (strcmp(engine, "labelset") == 0) {
+				options.engine = ENGINE_LABELSET;
+			} else if (strcmp(engine, "sjt") == 0) {
+				options.engine = ENGINE_SJT;
+			} else if (strcmp(engine, "simd") == 0) {
+				options.engine = ENGINE_SIMD;
+			} else {
+				printf("Unknown engine: %s\n", engine);
+				printUsage(argv[0]);
+				exit(1);
+			}
+		} else if (strcmp(arg, "--graph") == 0 && i1 + 1 < argc) {
+			options.graphFile = argv[++i1];
+		} else if (strcmp(arg, "--reorder") == 0) {
+			options.reorderSlots = 1;
+		} else if (strcmp(arg, "--symmetry") == 0) {
+			options.symmetry = 1;
+		} else if (strcmp(arg, "--memory") == 0 && i1 + 1 < argc) {
+			options.memoryLimit = atol(argv[++i1]) * 1024 * 1024;
+		} else if (strcmp(arg, "--scalar") == 0) {
+			options.scalar = 1;
+		} else if (strcmp(arg, "--codegen") == 0) {
+			options.codegen = 1;
+		} else if (strcmp(arg, "--count") == 0) {
+			options.countOnly = 1;
+		} else if (strcmp(arg, "--first") == 0) {
+			options.limit = 1;
+		} else if (strcmp(arg, "--limit") == 0 && i1 + 1 < argc) {
+			options.limit = atol(argv[++i1]);
+			if (options.limit <= 0) {
+				printf("The limit has to be at least 1.\n");
+				printUsage(argv[0]);
+				exit(1);
+			}
+		} else if (strcmp(arg, "--magic") == 0 && i1 + 1 < argc) {
+			char* magic = argv[++i1];
+			options.magicSet = 1;
+			int read = sscanf(magic, "%d:%d", &options.magicLow, &options.magicHigh);
+			if (read == 1) {
+				options.magicHigh = options.magicLow;
+			} else if (read != 2 || options.magicLow > options.magicHigh) {
+				printf("Unknown magic number range: %s\n", magic);
+				printUsage(argv[0]);
+				exit(1);
+			}
+		} else if (strcmp(arg, "--stream") == 0) {
+			options.stream = 1;
+		} else if (strcmp(arg, "--format") == 0 && i1 + 1 < argc) {
+			char* format = argv[++i1];
+			if (strcmp(format, "text") == 0) {
+				options.format = FORMAT_TEXT;
+			} else if (strcmp(format, "records") == 0) {
+				options.format = FORMAT_RECORDS;
+			} else if (strcmp(format, "ranks") == 0) {
+				options.format = FORMAT_RANKS;
+			} else {
+				printf("Unknown format: %s\n", format);
+				printUsage(argv[0]);
+				exit(1);
+			}
+		} else if (strncmp(arg, "--", 2) != 0 && positional < 2) {
+			if (positional == 0) {
+				options.cycleSize = atoi(arg);
+			} else {
+				options.connectingVertices = atoi(arg);
+			}
+			positional++;
+		} else {
+			printf("Unknown argument: %s\n", arg);
+			printUsage(argv[0]);
+			exit(1);
+		}
+	}
+
+	if (positional == 1) {
+		printf("Both the cycle size and the number of connecting vertices are needed.\n");
+		printUsage(argv[0]);
+		exit(1);
+	}
+
+	return options;
+}
+
+/**
+ * Print out how to run the program
+ * @param program The name the program was run with
+ */
+void printUsage(char* program) {
+	printf("Usage: %s [cycleSize connectingVertices] [options]\n", program);
+	printf("    --engine brute|backtrack|edge|mitm|labelset|sjt|simd\n");
+	printf("                                    Search engine to use (default backtrack)\n");
+	printf("    --graph filename                Read the graph from a file instead\n");
+	printf("    --reorder                       Reorder the slots in the brute force loop\n");
+	printf("                                    so vertices are closed as early as possible\n");
+	printf("    --symmetry                      Only find the smallest labeling of each\n");
+	printf("                                    orbit under the automorphisms of the graph\n");
+	printf("    --memory megabytes              Memory for the meet in the middle records\n");
+	printf("                                    of each process, shared by its threads,\n");
+	printf("                                    before they are spilled to disk (default 1024)\n");
+	printf("    --scalar                        Use the scalar path of the SIMD engine\n");
+	printf("    --codegen                       Generate and compile a check for the graph\n");
+	printf("                                    for the brute force loop\n");
+	printf("    --count                         Only count the labelings for each magic\n");
+	printf("                                    number instead of writing them out\n");
+	printf("    --first                         Stop after the first labeling found\n");
+	printf("    --limit count                   Stop after this many labelings are found\n");
+	printf("    --magic k|low:high              Only search for labelings with this magic\n");
+	printf("                                    number, or one in this range\n");
+	printf("    --stream                        MPI only: write out the labelings on a\n");
+	printf("                                    separate process while the search runs\n");
+	printf("    --format text|records|ranks     Write the labelings as text, or to a\n");
+	printf("                                    binary file of fixed size records or of\n");
+	printf("                                    compressed permutation indexes (default text)\n");
+}
+
+/**
+ * Check if the chosen engine finds labelings out of permutation index order,
+ * in which case they have to be sorted before they are written out
+ * @param options The parsed options
+ * @return 1 if the labelings need sorting, 0 if not
+ */
+int resultsUnordered(struct Options* options) {
+	if (options->engine == ENGINE_EDGE || options->engine == ENGINE_MITM ||
+		options->engine == ENGINE_LABELSET || options->engine == ENGINE_SJT) {
+		return 1;
+	}
+
+	//The backtracking search is split by magic number as well with --magic
+	if (options->engine == ENGINE_BACKTRACK && options->magicSet) {
+		return 1;
+	}
+	return options->engine == ENGINE_BRUTE && options->reorderSlots;
+}
+
+/**
+ * Get the name of the file the graph was read from, without the directories
+ * @param options The parsed options
+ * @return The name, or NULL for a generated graph
+ */
+const char* graphFileName(struct Options* options) {
+	if (options->graphFile == NULL) {
+		return NULL;
+	}
+	const char* slash = strrchr(options->graphFile, '/');
+	return slash != NULL ? slash + 1 : options->graphFile;
+}
+
+/**
+ * Name an output file after the graph, output_4_3.txt for a generated graph
+ * or output_tri.txt for one read from graphs/tri.txt
+ * @param options The parsed options
+ * @param extension The extension of the file, without the dot
+ * @param filename Set to the name of the file
+ * @param size The room in filename
+ */
+void outputFilename(struct Options* options, const char* extension, char* filename, int size) {
+	const char* name = graphFileName(options);
+	if (name == NULL) {
+		snprintf(filename, size, "output_%d_%d.%s", options->cycleSize, options->connectingVertices, extension);
+		return;
+	}
+
+	//Leave off the extension of the graph file
+	const char* dot = strrchr(name, '.');
+	int length = dot != NULL && dot != name ? dot - name : strlen(name);
+	snprintf(filename, size, "output_%.*s.%s", length, name, extension);
+}
+
+/**
+ * Make the first line of the output file, describing the graph
+ * @param options The parsed options
+ * @param line Set to the line, ending in a newline
+ * @param size The room in line
+ */
+void outputGraphLine(struct Options* options, char* line, int size) {
+	const char* name = graphFileName(options);
+	if (name == NULL) {
+		snprintf(line, size, "Graph: Cycle size = %d, connecting vertices = %d\n",
+			options->cycleSize, options->connectingVertices);
+	} else {
+		snprintf(line, size, "Graph: File = %s\n", name);
+	}
+}
+
+#endif
@@ -0,0 +1,152 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//The type of a permutation index. A long only holds up to 20!, and the larger
+//graphs need more, so indexes are unsigned 128 bit integers, which hold up to
+//34!. Anything bigger is caught when the number of permutations is worked
+//out, before any search starts.
+//
+//printf and scanf have no format for 128 bit integers, so indexes are written
+//and read as decimal strings. The MPI programs send them with their own
+//datatype of two 64 bit integers, and add them up with their own operation.
+
+#ifndef PERM_INDEX_H
+#define PERM_INDEX_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef unsigned __int128 PermIndex;
+
+//The largest permutation whose number of permutations fits in a PermIndex
+#define MAX_PERM_SIZE 34
+
+//Enough characters for the 39 digits of the largest PermIndex
+#define PERM_INDEX_DIGITS 40
+
+//n! for every n up to MAX_PERM_SIZE, worked out at compile time
+struct FactorialTable {
+	PermIndex value[MAX_PERM_SIZE + 1];
+
+	constexpr FactorialTable() : value() {
+		value[0] = 1;
+		for (int n = 1; n <= MAX_PERM_SIZE; n++) {
+			value[n] = value[n - 1] * n;
+		}
+	}
+};
+
+constexpr FactorialTable factorialTable = FactorialTable();
+
+PermIndex factorialIndex(int n);
+PermIndex divideIndex(PermIndex a, PermIndex b);
+char* formatPermIndex(PermIndex idx, char* buffer);
+PermIndex parsePermIndex(const char* text);
+
+/**
+ * Work out n!, stopping the program if it does not fit in a PermIndex
+ * @param n The number to take the factorial of
+ * @return n!
+ */
+PermIndex factorialIndex(int n) {
+	if (n > MAX_PERM_SIZE) {
+		printf("%d! permutations is too many, at most %d labels are supported.\n", n, MAX_PERM_SIZE);
+		exit(1);
+	}
+	return factorialTable.value[n];
+}
+
+/**
+ * Divide two indexes, using 64 bit division when both fit, which is much
+ * faster than the 128 bit library call
+ * @param a The index to divide
+ * @param b The index to divide by
+ * @return a / b
+ */
+inline PermIndex divideIndex(PermIndex a, PermIndex b) {
+	if ((a >> 64) == 0 && (b >> 64) == 0) {
+		return (unsigned long long) a / (unsigned long long) b;
+	}
+	return a / b;
+}
+
+/**
+ * Write an index out in decimal
+ * @param idx The index
+ * @param buffer Array of at least PERM_INDEX_DIGITS characters to hold it
+ * @return The buffer
+ */
+char* formatPermIndex(PermIndex idx, char* buffer) {
+	char digits[PERM_INDEX_DIGITS];
+	int count = 0;
+	do {
+		digits[count++] = '0' + (int) (idx % 10);
+		idx /= 10;
+	} while (idx > 0);
+
+	for (int i1 = 0; i1 < count; i1++) {
+		buffer[i1] = digits[count - 1 - i1];
+	}
+	buffer[count] = '\0';
+	return buffer;
+}
+
+/**
+ * Read an index written out in decimal
+ * @param text The digits, anything after them is ignored
+ * @return The index
+ */
+PermIndex parsePermIndex(const char* text) {
+	PermIndex idx = 0;
+	while (*text == ' ') {
+		text++;
+	}
+	while (*text >= '0' && *text <= '9') {
+		idx = idx * 10 + (*text - '0');
+		text++;
+	}
+	return idx;
+}
+
+#ifdef MPI_VERSION
+/**
+ * The MPI datatype for a PermIndex, made the first time it is needed
+ * @return The datatype
+ */
+MPI_Datatype permIndexType() {
+	static MPI_Datatype type = MPI_DATATYPE_NULL;
+	if (type == MPI_DATATYPE_NULL) {
+		MPI_Type_contiguous(2, MPI_UINT64_T, &type);
+		MPI_Type_commit(&type);
+	}
+	return type;
+}
+
+/**
+ * Add up arrays of indexes for MPI_Reduce
+ * @param in The indexes from one process
+ * @param inout The indexes to add them to
+ * @param len The number of indexes
+ * The datatype is always permIndexType(), so it is left unnamed
+ */
+void sumPermIndexes(void* in, void* inout, int* len, MPI_Datatype*) {
+	PermIndex* from = (PermIndex *) in;
+	PermIndex* into = (PermIndex *) inout;
+	for (int i1 = 0; i1 < *len; i1++) {
+		into[i1] += from[i1];
+	}
+}
+
+/**
+ * The MPI operation that adds up indexes, made the first time it is needed
+ * @return The operation
+ */
+MPI_Op permIndexSum() {
+	static MPI_Op op = MPI_OP_NULL;
+	if (op == MPI_OP_NULL) {
+		MPI_Op_create(sumPermIndexes, 1, &op);
+	}
+	return op;
+}
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//A range of permutation indexes [begin, end) along with the permutation at
+//the current index. Stepping to the next permutation is amortized O(1), and
+//the range can also jump forward by any number of indexes or past a block of
+//permutations that fail in the same way. After every move the first position
+//that changed is kept, so incremental checks only redo the positions after it.
+//
+//Ranges split into balanced parts, which is how the work is shared out
+//between threads and processes: every part gets the same number of indexes,
+//and the first few get one more when it does not divide evenly.
+
+#ifndef PERM_RANGE_H
+#define PERM_RANGE_H
+
+#include "perm_index.h"
+#include "perm_rank.h"
+#include "prefix_skip.h"
+
+//Struct for a range of permutations
+struct PermRange {
+	int permSize;
+	PermIndex begin;
+	PermIndex end;
+
+	//The current index and its permutation
+	PermIndex index;
+	int permutation[MAX_PERM_SIZE];
+
+	//The first position that changed on the last move
+	int changed;
+};
+
+struct PermRange createPermRange(int permSize, PermIndex begin, PermIndex end);
+struct PermRange splitPermRange(int permSize, PermIndex begin, PermIndex end, int parts, int part);
+void splitRange(PermIndex begin, PermIndex end, int parts, int part,
+	PermIndex* partBegin, PermIndex* partEnd);
+void stepRange(struct PermRange* range);
+void jumpRange(struct PermRange* range, PermIndex offset);
+void skipRangePrefix(struct PermRange* range, struct PrefixSkip* ps, int failed);
+
+/**
+ * Set up a range, starting at its first permutation
+ * @param permSize The size of the permutations
+ * @param begin The first index in the range
+ * @param end One past the last index in the range
+ * @return The range
+ */
+struct PermRange createPermRange(int permSize, PermIndex begin, PermIndex end) {
+	struct PermRange range;
+	range.permSize = permSize;
+	range.begin = begin;
+	range.end = end;
+	range.index = begin;
+	range.changed = 0;
+	unrankPermutation(begin < end ? begin : 0, permSize, range.permutation);
+	return range;
+}
+
+/**
+ * Set up one of the balanced parts of a range
+ * @param permSize The size of the permutations
+ * @param begin The first index in the whole range
+ * @param end One past the last index in the whole range
+ * @param parts The number of parts to split the range into
+ * @param part Which part to set up, from 0 to parts - 1
+ * @return The part of the range
+ */
+struct PermRange splitPermRange(int permSize, PermIndex begin, PermIndex end, int parts, int part) {
+	PermIndex partBegin, partEnd;
+	splitRange(begin, end, parts, part, &partBegin, &partEnd);
+	return createPermRange(permSize, partBegin, partEnd);
+}
+
+/**
+ * Find the bounds of one of the balanced parts of a range of indexes. The
+ * same split works for ranges of other units of work.
+ * @param begin The first index in the whole range
+ * @param end One past the last index in the whole range
+ * @param parts The number of parts to split the range into
+ * @param part Which part to find, from 0 to parts - 1
+ * @param partBegin Set to the first index in the part
+ * @param partEnd Set to one past the last index in the part
+ */
+void splitRange(PermIndex begin, PermIndex end, int parts, int part,
+	PermIndex* partBegin, PermIndex* partEnd) {
+	PermIndex chunkSize = (end - begin) / parts;
+	PermIndex numDoOneMore = (end - begin) - chunkSize * parts;
+
+	//The first numDoOneMore parts each take one extra index
+	*partBegin = begin + part * chunkSize;
+	*partEnd = *partBegin + chunkSize;
+	if ((PermIndex) part < numDoOneMore) {
+		*partBegin += part;
+		*partEnd += part + 1;
+	} else {
+		*partBegin += numDoOneMore;
+		*partEnd += numDoOneMore;
+	}
+}
+
+/**
+ * Move to the next permutation
+ * @param range The range
+ */
+void stepRange(struct PermRange* range) {
+	range->changed = nextPermutation(range->permutation, range->permSize);
+	range->index++;
+}
+
+/**
+ * Move forward by some number of indexes
+ * @param range The range
+ * @param offset How many indexes to move forward
+ */
+void jumpRange(struct PermRange* range, PermIndex offset) {
+	range->changed = skipPermutation(range->permutation, range->permSize, offset);
+	range->index += offset;
+}
+
+/**
+ * Move past every permutation sharing the prefix a failed check depended on
+ * @param range The range
+ * @param ps The prefix skipping struct of the loop
+ * @param failed The index in the check order of the vertex that failed
+ */
+void skipRangePrefix(struct PermRange* range, struct PrefixSkip* ps, int failed) {
+	range->index = skipPrefix(ps, range->permutation, range->index, failed, &range->changed);
+}
+
+#endif
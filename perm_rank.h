@@ -0,0 +1,226 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Ranking and unranking of permutations. The rank of a permutation of 1 to
+//permSize is its index in lexicographic order, the same index the brute force
+//loop counts with.
+//
+//A permutation is ranked through its factoradic digits, where the digit for a
+//position is how many of the labels after it are smaller. The labels still in
+//play are kept in a Fenwick tree, so counting the smaller ones and picking the
+//k-th smallest are both O(log n), and ranking or unranking is O(n log n).
+//Moving a permutation forward by some number of indexes adds the number to
+//its digits and only rebuilds the positions from the first digit that
+//changed, which is how a sorted list of indexes is unranked one after another.
+
+#ifndef PERM_RANK_H
+#define PERM_RANK_H
+
+#include "perm_index.h"
+
+//Fenwick tree over the labels 1 to size, counting which ones are present
+struct LabelTree {
+	int size;
+	int top;
+	int tree[MAX_PERM_SIZE + 1];
+};
+
+void initLabelTree(struct LabelTree* lt, int size);
+void addLabel(struct LabelTree* lt, int label, int change);
+int countBelow(const struct LabelTree* lt, int label);
+int selectLabel(const struct LabelTree* lt, int k);
+void placeDigits(const int* digits, int permSize, int from, int* permutation);
+PermIndex rankPermutation(const int* permutation, int permSize);
+void unrankPermutation(PermIndex rank, int permSize, int* permutation);
+int skipPermutation(int* permutation, int permSize, PermIndex count);
+void unrankBatch(const PermIndex* ranks, long count, int permSize, int* permutations);
+
+/**
+ * Set up an empty tree
+ * @param lt The tree
+ * @param size The largest label
+ */
+void initLabelTree(struct LabelTree* lt, int size) {
+	lt->size = size;
+	lt->top = 1;
+	while (lt->top * 2 <= size) {
+		lt->top *= 2;
+	}
+	for (int i1 = 0; i1 <= size; i1++) {
+		lt->tree[i1] = 0;
+	}
+}
+
+/**
+ * Add or remove a label
+ * @param lt The tree
+ * @param label The label
+ * @param change 1 to add the label, -1 to remove it
+ */
+void addLabel(struct LabelTree* lt, int label, int change) {
+	for (int i1 = label; i1 <= lt->size; i1 += i1 & -i1) {
+		lt->tree[i1] += change;
+	}
+}
+
+/**
+ * Count the labels in the tree smaller than a label
+ * @param lt The tree
+ * @param label The label
+ * @return How many labels in the tree are smaller
+ */
+int countBelow(const struct LabelTree* lt, int label) {
+	int count = 0;
+	for (int i1 = label - 1; i1 > 0; i1 -= i1 & -i1) {
+		count += lt->tree[i1];
+	}
+	return count;
+}
+
+/**
+ * Find the k-th smallest label in the tree
+ * @param lt The tree
+ * @param k How many labels in the tree are smaller than the one to find
+ * @return The label
+ */
+int selectLabel(const struct LabelTree* lt, int k) {
+	//Walk down the tree, taking each block that is entirely below the label
+	int pos = 0;
+	for (int step = lt->top; step > 0; step /= 2) {
+		if (pos + step <= lt->size && lt->tree[pos + step] <= k) {
+			pos += step;
+			k -= lt->tree[pos];
+		}
+	}
+	return pos + 1;
+}
+
+/**
+ * Rebuild the positions of a permutation from one position on from their
+ * factoradic digits, using the labels already in those positions
+ * @param digits The factoradic digit of each position
+ * @param permSize The size of the permutation
+ * @param from The first position to rebuild
+ * @param permutation The permutation, changed in place
+ */
+void placeDigits(const int* digits, int permSize, int from, int* permutation) {
+	struct LabelTree lt;
+	initLabelTree(&lt, permSize);
+	for (int i1 = from; i1 < permSize; i1++) {
+		addLabel(&lt, permutation[i1], 1);
+	}
+	for (int i1 = from; i1 < permSize; i1++) {
+		permutation[i1] = selectLabel(&lt, digits[i1]);
+		addLabel(&lt, permutation[i1], -1);
+	}
+}
+
+/**
+ * Find the lexicographic index of a permutation, the inverse of
+ * unrankPermutation
+ * @param permutation The permutation of 1 to permSize
+ * @param permSize The size of the permutation
+ * @return The index of the permutation
+ */
+PermIndex rankPermutation(const int* permutation, int permSize) {
+	struct LabelTree lt;
+	initLabelTree(&lt, permSize);
+	for (int label = 1; label <= permSize; label++) {
+		addLabel(&lt, label, 1);
+	}
+
+	PermIndex rank = 0;
+	for (int i1 = 0; i1 < permSize; i1++) {
+		//The labels after this one that are smaller, the factoradic digit
+		rank = rank * (permSize - i1) + countBelow(&lt, permutation[i1]);
+		addLabel(&lt, permutation[i1], -1);
+	}
+	return rank;
+}
+
+/**
+ * Find the permutation with a lexicographic index
+ * @param rank The index, less than permSize!
+ * @param permSize The size of the permutation
+ * @param permutation Array to hold the permutation of 1 to permSize
+ */
+void unrankPermutation(PermIndex rank, int permSize, int* permutation) {
+	int digits[permSize];
+	for (int i1 = 0; i1 < permSize; i1++) {
+		PermIndex block = factorialTable.value[permSize - 1 - i1];
+		digits[i1] = divideIndex(rank, block);
+		rank -= digits[i1] * block;
+		permutation[i1] = i1 + 1;
+	}
+	placeDigits(digits, permSize, 0, permutation);
+}
+
+/**
+ * Move a permutation forward by some number of indexes. Going past the last
+ * permutation wraps around to the first, like nextPermutation.
+ * @param permutation The permutation, changed in place
+ * @param permSize The size of the permutation
+ * @param count How many indexes to move forward
+ * @return The first position that changed, or permSize if none did
+ */
+int skipPermutation(int* permutation, int permSize, PermIndex count) {
+	if (count == 0) {
+		return permSize;
+	}
+
+	//Work out the factoradic digits
+	int digits[permSize];
+	struct LabelTree lt;
+	initLabelTree(&lt, permSize);
+	for (int i1 = 0; i1 < permSize; i1++) {
+		addLabel(&lt, permutation[i1], 1);
+	}
+	for (int i1 = 0; i1 < permSize; i1++) {
+		digits[i1] = countBelow(&lt, permutation[i1]);
+		addLabel(&lt, permutation[i1], -1);
+	}
+
+	//Add the count to the digits from the last one, the digit of position i1
+	//counts up to permSize - i1 before carrying
+	int from = permSize;
+	PermIndex carry = count;
+	for (int i1 = permSize - 1; i1 >= 0 && carry > 0; i1--) {
+		int radix = permSize - i1;
+		PermIndex total = digits[i1] + carry;
+		int digit = total % radix;
+		carry = total / radix;
+		if (digit != digits[i1]) {
+			digits[i1] = digit;
+			from = i1;
+		}
+	}
+
+	if (from < permSize) {
+		placeDigits(digits, permSize, from, permutation);
+	}
+	return from;
+}
+
+/**
+ * Find the permutations for a list of indexes in increasing order, moving
+ * from each one to the next instead of starting over every time
+ * @param ranks The indexes in increasing order
+ * @param count The number of indexes
+ * @param permSize The size of the permutations
+ * @param permutations Array of count * permSize to hold the permutations, one
+ *                     after another
+ */
+void unrankBatch(const PermIndex* ranks, long count, int permSize, int* permutations) {
+	for (long i1 = 0; i1 < count; i1++) {
+		int* permutation = permutations + i1 * permSize;
+		if (i1 == 0 || ranks[i1] < ranks[i1 - 1]) {
+			unrankPermutation(ranks[i1], permSize, permutation);
+		} else {
+			for (int i2 = 0; i2 < permSize; i2++) {
+				permutation[i2] = permutation[i2 - permSize];
+			}
+			skipPermutation(permutation, permSize, ranks[i1] - ranks[i1 - 1]);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,306 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Brute force search in plain changes (Steinhaus-Johnson-Trotter) order, where
+//each permutation differs from the one before by swapping two neighbouring
+//slots. Only the vertices touched by those two slots change value, and a count
+//of how many vertices have each value is kept, so a labeling is magic when the
+//count for the value of any one vertex is the number of vertices.
+//
+//The order is built up one label at a time: the permutations of labels 1 to m
+//are the permutations of 1 to m - 1 with label m swept across them, from right
+//to left after an even permutation of the smaller labels and from left to
+//right after an odd one. That gives ranking and unranking in plain changes
+//order, so a search can start anywhere and be split up by index like the
+//brute force loop. The indexes are not permutation indexes, so labelings are
+//ranked again in lexicographic order and are not found in index order.
+
+#ifndef PLAIN_CHANGES_H
+#define PLAIN_CHANGES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "incidence.h"
+#include "automorphism.h"
+#include "magic_range.h"
+#include "perm_index.h"
+#include "perm_rank.h"
+#include "results.h"
+
+//Struct for the plain changes search
+struct PlainChanges {
+	int vertices;
+	int permSize;
+
+	//Vertices touched by each slot, and whether the slot is added or subtracted
+	int* touchStart;
+	int* touchVertex;
+	int* touchSign;
+
+	//The automorphisms of the graph, or NULL to keep every labeling
+	struct Symmetry* symmetry;
+
+	//The magic numbers to search for
+	struct MagicRange magic;
+
+	//The current permutation, the slot of each label, and for each label the
+	//direction it is moving and how far it has gone in its current sweep
+	int* permutation;
+	int* where;
+	int* direction;
+	int* moved;
+
+	//The value of each vertex, and how many vertices have each value
+	int* values;
+	int* valueCount;
+	int valueOffset;
+};
+
+struct PlainChanges createPlainChanges(int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry, struct MagicRange magic);
+void plainChangesRange(struct PlainChanges* pc, PermIndex start, PermIndex end,
+	struct Results* results);
+int stepPlainChanges(struct PlainChanges* pc);
+void swapPlainChanges(struct PlainChanges* pc, int pos);
+void moveSlot(struct PlainChanges* pc, int slot, int change);
+void unrankPlainChanges(PermIndex rank, int permSize, int* permutation, int* direction, int* moved);
+PermIndex rankPlainChanges(const int* permutation, int permSize);
+void freePlainChanges(struct PlainChanges* pc);
+
+/**
+ * Set up a plain changes search for a graph
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param symmetry The automorphisms of the graph to only keep the smallest
+ *                 labeling of each orbit, or NULL to keep every labeling
+ * @param magic The magic numbers to search for
+ * @return A struct for the search, freed with freePlainChanges
+ */
+struct PlainChanges createPlainChanges(int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry, struct MagicRange magic) {
+	struct PlainChanges pc;
+	int permSize = vertices + edges;
+	pc.vertices = vertices;
+	pc.permSize = permSize;
+	pc.symmetry = symmetry;
+	pc.magic = magic;
+
+	struct Incidence inc = buildIncidence(vertices, edges, matrix);
+	int incSize = inc.start[vertices];
+
+	//Invert the incidence lists so each slot knows the vertices it touches
+	pc.touchStart = (int *) calloc(permSize + 1, sizeof(int));
+	pc.touchVertex = (int *) malloc(incSize * sizeof(int));
+	pc.touchSign = (int *) malloc(incSize * sizeof(int));
+	for (int i1 = 0; i1 < incSize; i1++) {
+		pc.touchStart[inc.slot[i1] + 1]++;
+	}
+	int touchCount[permSize];
+	for (int slot = 0; slot < permSize; slot++) {
+		pc.touchStart[slot + 1] += pc.touchStart[slot];
+		touchCount[slot] = pc.touchStart[slot];
+	}
+	int maxDegree = 0;
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		for (int i1 = inc.start[vertex]; i1 < inc.start[vertex + 1]; i1++) {
+			int slot = inc.slot[i1];
+			pc.touchVertex[touchCount[slot]] = vertex;
+			pc.touchSign[touchCount[slot]] = inc.sign[i1];
+			touchCount[slot]++;
+		}
+		if (inc.start[vertex + 1] - inc.start[vertex] > maxDegree) {
+			maxDegree = inc.start[vertex + 1] - inc.start[vertex];
+		}
+	}
+
+	freeIncidence(&inc);
+
+	//A vertex adds or subtracts at most maxDegree labels of at most permSize
+	pc.valueOffset = maxDegree * permSize;
+	pc.valueCount = (int *) calloc(2 * pc.valueOffset + 1, sizeof(int));
+
+	pc.permutation = (int *) malloc(permSize * sizeof(int));
+	pc.where = (int *) malloc((permSize + 1) * sizeof(int));
+	pc.direction = (int *) malloc((permSize + 1) * sizeof(int));
+	pc.moved = (int *) malloc((permSize + 1) * sizeof(int));
+	pc.values = (int *) malloc(vertices * sizeof(int));
+
+	return pc;
+}
+
+/**
+ * Find every labeling with a plain changes index in [start, end). The
+ * permutation index and magic number of each labeling found are added to the
+ * results, not in index order.
+ * @param pc The search to run
+ * @param start The first plain changes index to check
+ * @param end One past the last plain changes index to check
+ * @param results The results to add the labelings found to
+ */
+void plainChangesRange(struct PlainChanges* pc, PermIndex start, PermIndex end,
+	struct Results* results) {
+	if (start >= end) {
+		return;
+	}
+
+	int vertices = pc->vertices;
+	int permSize = pc->permSize;
+	unrankPlainChanges(start, permSize, pc->permutation, pc->direction, pc->moved);
+
+	//Work out every vertex value from scratch once
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		pc->values[vertex] = 0;
+	}
+	for (int slot = 0; slot < permSize; slot++) {
+		pc->where[pc->permutation[slot]] = slot;
+		for (int i1 = pc->touchStart[slot]; i1 < pc->touchStart[slot + 1]; i1++) {
+			pc->values[pc->touchVertex[i1]] += pc->touchSign[i1] * pc->permutation[slot];
+		}
+	}
+	for (int i1 = 0; i1 <= 2 * pc->valueOffset; i1++) {
+		pc->valueCount[i1] = 0;
+	}
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		pc->valueCount[pc->values[vertex] + pc->valueOffset]++;
+	}
+
+	for (PermIndex idx = start; idx < end && !searchStopped(results); idx++) {
+		//Every vertex has the same value as vertex 0
+		if (pc->valueCount[pc->values[0] + pc->valueOffset] == vertices && inMagicRange(pc->magic, pc->values[0])) {
+			if (pc->symmetry == NULL || isCanonical(pc->symmetry, pc->permutation)) {
+				addResult(results, rankPermutation(pc->permutation, permSize), pc->values[0]);
+			}
+		}
+
+		if (idx + 1 < end) {
+			swapPlainChanges(pc, stepPlainChanges(pc));
+		}
+	}
+}
+
+/**
+ * Find the two neighbouring slots to swap to get to the next permutation in
+ * plain changes order. The largest label that has not finished its sweep
+ * moves, and every larger label turns around.
+ * @param pc The search
+ * @return The left slot of the two to swap
+ */
+int stepPlainChanges(struct PlainChanges* pc) {
+	for (int label = pc->permSize; label >= 2; label--) {
+		if (pc->moved[label] < label - 1) {
+			pc->moved[label]++;
+			int pos = pc->where[label];
+			return pc->direction[label] < 0 ? pos - 1 : pos;
+		}
+		pc->moved[label] = 0;
+		pc->direction[label] = -pc->direction[label];
+	}
+
+	//The last permutation, there is nothing after it
+	return -1;
+}
+
+/**
+ * Swap the labels in two neighbouring slots and update the vertex values and
+ * the count of each value
+ * @param pc The search
+ * @param pos The left slot of the two to swap
+ */
+void swapPlainChanges(struct PlainChanges* pc, int pos) {
+	int left = pc->permutation[pos];
+	int right = pc->permutation[pos + 1];
+	pc->permutation[pos] = right;
+	pc->permutation[pos + 1] = left;
+	pc->where[right] = pos;
+	pc->where[left] = pos + 1;
+
+	moveSlot(pc, pos, right - left);
+	moveSlot(pc, pos + 1, left - right);
+}
+
+/**
+ * Apply a change in the label of one slot to the vertices it touches
+ * @param pc The search
+ * @param slot The slot whose label changed
+ * @param change The new label minus the old label
+ */
+void moveSlot(struct PlainChanges* pc, int slot, int change) {
+	for (int i1 = pc->touchStart[slot]; i1 < pc->touchStart[slot + 1]; i1++) {
+		int vertex = pc->touchVertex[i1];
+		pc->valueCount[pc->values[vertex] + pc->valueOffset]--;
+		pc->values[vertex] += pc->touchSign[i1] * change;
+		pc->valueCount[pc->values[vertex] + pc->valueOffset]++;
+	}
+}
+
+/**
+ * Find the permutation with a given index in plain changes order, along with
+ * the direction each label is moving and how far into its sweep it is
+ * @param rank The plain changes index
+ * @param permSize The size of the permutation
+ * @param permutation Array to hold the permutation
+ * @param direction Array of permSize + 1 to hold the direction of each label,
+ *                  -1 for left and 1 for right
+ * @param moved Array of permSize + 1 to hold how many steps each label has
+ *              taken in its sweep
+ */
+void unrankPlainChanges(PermIndex rank, int permSize, int* permutation, int* direction, int* moved) {
+	//The index of the permutation of labels 1 to m is rank / (permSize! / m!)
+	PermIndex subRank[permSize + 1];
+	subRank[permSize] = rank;
+	for (int label = permSize; label >= 1; label--) {
+		subRank[label - 1] = subRank[label] / label;
+	}
+
+	//Insert the labels one at a time
+	permutation[0] = 1;
+	for (int label = 2; label <= permSize; label++) {
+		moved[label] = subRank[label] % label;
+		direction[label] = subRank[label - 1] % 2 == 0 ? -1 : 1;
+		int pos = direction[label] < 0 ? label - 1 - moved[label] : moved[label];
+		for (int i1 = label - 1; i1 > pos; i1--) {
+			permutation[i1] = permutation[i1 - 1];
+		}
+		permutation[pos] = label;
+	}
+}
+
+/**
+ * Find the index of a permutation in plain changes order
+ * @param permutation The permutation of the labels 1 to permSize
+ * @param permSize The size of the permutation
+ * @return The plain changes index
+ */
+PermIndex rankPlainChanges(const int* permutation, int permSize) {
+	PermIndex rank = 0;
+	for (int label = 2; label <= permSize; label++) {
+		//Position of the label among the labels no larger than it
+		int pos = 0;
+		for (int i1 = 0; i1 < permSize && permutation[i1] != label; i1++) {
+			pos += permutation[i1] < label;
+		}
+		int moved = rank % 2 == 0 ? label - 1 - pos : pos;
+		rank = rank * label + moved;
+	}
+	return rank;
+}
+
+/**
+ * Free the arrays of a plain changes search
+ * @param pc The search to free
+ */
+void freePlainChanges(struct PlainChanges* pc) {
+	free(pc->touchStart);
+	free(pc->touchVertex);
+	free(pc->touchSign);
+	free(pc->permutation);
+	free(pc->where);
+	free(pc->direction);
+	free(pc->moved);
+	free(pc->values);
+	free(pc->valueCount);
+}
+
+#endif
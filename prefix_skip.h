@@ -0,0 +1,247 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Prefix skipping for the brute force loop. std::next_permutation only changes
+//a suffix of the permutation, so when a vertex fails the check and its value
+//and the magic number only depend on positions in a prefix, every permutation
+//until that prefix changes fails in the same way. Those permutations are all
+//in one block of (permSize - 1 - last position)! indexes, so the loop can jump
+//straight to the start of the next block.
+//
+//The vertices are checked in the order their last position comes up, so the
+//vertex that fails first is usually one that only depends on a short prefix.
+//Optionally the slots can also be reordered so the first positions close
+//vertices as early as possible. The permutation is then over positions
+//instead of slots, and labelings have to be put back in slot order and
+//sorted before output.
+
+#ifndef PREFIX_SKIP_H
+#define PREFIX_SKIP_H
+
+#include <stdlib.h>
+#include <algorithm>
+#include <functional>
+
+#include "incidence.h"
+#include "perm_index.h"
+
+//Struct for skipping prefixes in the brute force loop
+struct PrefixSkip {
+	int permSize;
+
+	//The slot at each position of the permutation, and the position of each
+	//slot. Both are the identity unless the slots are reordered.
+	int* order;
+	int* position;
+
+	//The vertices in the order they are checked
+	int* checkOrder;
+
+	//For each vertex in checkOrder, the last position its check depends on,
+	//and the number of permutations sharing the prefix up to that position
+	int* skipPosition;
+	PermIndex* skipBlock;
+};
+
+struct PrefixSkip createPrefixSkip(int vertices, int edges, int** matrix, int reorder);
+PermIndex skipPrefix(struct PrefixSkip* ps, int* permutation, PermIndex permIdx, int failed, int* changed);
+int nextPermutation(int* permutation, int permSize);
+void slotOrderLabeling(struct PrefixSkip* ps, const int* permutation, int* labeling);
+void freePrefixSkip(struct PrefixSkip* ps);
+
+/**
+ * Work out the position of each slot and the order to check the vertices in
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param reorder 1 to reorder the slots so vertices close early, 0 to keep
+ *                the slots in order
+ * @return A struct for skipping prefixes, freed with freePrefixSkip
+ */
+struct PrefixSkip createPrefixSkip(int vertices, int edges, int** matrix, int reorder) {
+	struct PrefixSkip ps;
+	int permSize = vertices + edges;
+	ps.permSize = permSize;
+	ps.order = (int *) malloc(permSize * sizeof(int));
+	ps.position = (int *) malloc(permSize * sizeof(int));
+	ps.checkOrder = (int *) malloc(vertices * sizeof(int));
+	ps.skipPosition = (int *) malloc(vertices * sizeof(int));
+	ps.skipBlock = (PermIndex *) malloc(vertices * sizeof(PermIndex));
+
+	struct Incidence inc = buildIncidence(vertices, edges, matrix);
+
+	for (int slot = 0; slot < permSize; slot++) {
+		ps.order[slot] = slot;
+		ps.position[slot] = slot;
+	}
+
+	if (reorder) {
+		//Greedily close the vertex that needs the fewest new slots, and put
+		//its slots at the next positions
+		int placed[permSize];
+		int closed[vertices];
+		for (int slot = 0; slot < permSize; slot++) {
+			placed[slot] = 0;
+		}
+		for (int vertex = 0; vertex < vertices; vertex++) {
+			closed[vertex] = 0;
+		}
+
+		int count = 0;
+		for (int i1 = 0; i1 < vertices; i1++) {
+			int best = -1;
+			int bestNeeded = permSize + 1;
+			for (int vertex = 0; vertex < vertices; vertex++) {
+				if (closed[vertex]) {
+					continue;
+				}
+				int needed = 0;
+				for (int i2 = inc.start[vertex]; i2 < inc.start[vertex + 1]; i2++) {
+					needed += !placed[inc.slot[i2]];
+				}
+				if (needed < bestNeeded) {
+					best = vertex;
+					bestNeeded = needed;
+				}
+			}
+
+			closed[best] = 1;
+			for (int i2 = inc.start[best]; i2 < inc.start[best + 1]; i2++) {
+				int slot = inc.slot[i2];
+				if (!placed[slot]) {
+					placed[slot] = 1;
+					ps.order[count++] = slot;
+				}
+			}
+		}
+
+		//Edges that are not in any list go at the end
+		for (int slot = 0; slot < permSize; slot++) {
+			if (!placed[slot]) {
+				ps.order[count++] = slot;
+			}
+		}
+
+		for (int pos = 0; pos < permSize; pos++) {
+			ps.position[ps.order[pos]] = pos;
+		}
+	}
+
+	//Check the vertices in the order their last position comes up
+	int lastPosition[vertices];
+	for (int vertex = 0; vertex < vertices; vertex++) {
+		lastPosition[vertex] = 0;
+		for (int i1 = inc.start[vertex]; i1 < inc.start[vertex + 1]; i1++) {
+			if (ps.position[inc.slot[i1]] > lastPosition[vertex]) {
+				lastPosition[vertex] = ps.position[inc.slot[i1]];
+			}
+		}
+		ps.checkOrder[vertex] = vertex;
+	}
+	for (int i1 = 1; i1 < vertices; i1++) {
+		int vertex = ps.checkOrder[i1];
+		int i2 = i1;
+		while (i2 > 0 && lastPosition[ps.checkOrder[i2 - 1]] > lastPosition[vertex]) {
+			ps.checkOrder[i2] = ps.checkOrder[i2 - 1];
+			i2--;
+		}
+		ps.checkOrder[i2] = vertex;
+	}
+
+	//A vertex fails against the magic number, which comes from the first
+	//vertex checked, so the check depends on the positions of both
+	int magicPosition = lastPosition[ps.checkOrder[0]];
+	for (int i1 = 0; i1 < vertices; i1++) {
+		int pos = lastPosition[ps.checkOrder[i1]];
+		if (magicPosition > pos) {
+			pos = magicPosition;
+		}
+		ps.skipPosition[i1] = pos;
+
+		PermIndex block = 1;
+		for (int i2 = 2; i2 <= permSize - 1 - pos; i2++) {
+			block *= i2;
+		}
+		ps.skipBlock[i1] = block;
+	}
+
+	freeIncidence(&inc);
+
+	return ps;
+}
+
+/**
+ * Move to the first permutation after the block that shares the prefix the
+ * failed check depends on
+ * @param ps The prefix skipping struct
+ * @param permutation The permutation that failed, changed in place
+ * @param permIdx The index of the permutation that failed
+ * @param failed The index in checkOrder of the vertex that failed
+ * @param changed Set to the first position that changed
+ * @return The index of the new permutation
+ */
+PermIndex skipPrefix(struct PrefixSkip* ps, int* permutation, PermIndex permIdx, int failed, int* changed) {
+	PermIndex block = ps->skipBlock[failed];
+	if (block > 1) {
+		//The last permutation with this prefix has the rest in decreasing
+		//order, and the next one after it starts the next block
+		std::sort(permutation + ps->skipPosition[failed] + 1,
+			permutation + ps->permSize, std::greater<int>());
+		permIdx = divideIndex(permIdx, block) * block + block - 1;
+	}
+	*changed = nextPermutation(permutation, ps->permSize);
+	return permIdx + 1;
+}
+
+/**
+ * Move to the next permutation in lexicographic order, like
+ * std::next_permutation, but say where the permutation started changing
+ * @param permutation The permutation, changed in place
+ * @param permSize The size of the permutation
+ * @return The first position that changed
+ */
+int nextPermutation(int* permutation, int permSize) {
+	//Find the last position smaller than the one after it
+	int pivot = permSize - 2;
+	while (pivot >= 0 && permutation[pivot] > permutation[pivot + 1]) {
+		pivot--;
+	}
+
+	//Swap it with the smallest larger value after it, and put the rest in
+	//increasing order. The last permutation goes back to the first.
+	if (pivot >= 0) {
+		int swap = permSize - 1;
+		while (permutation[swap] < permutation[pivot]) {
+			swap--;
+		}
+		std::swap(permutation[pivot], permutation[swap]);
+	}
+	std::reverse(permutation + pivot + 1, permutation + permSize);
+
+	return pivot >= 0 ? pivot : 0;
+}
+
+/**
+ * Put a permutation over positions back in slot order
+ * @param ps The prefix skipping struct
+ * @param permutation The permutation over positions
+ * @param labeling Array to hold the label of each slot
+ */
+void slotOrderLabeling(struct PrefixSkip* ps, const int* permutation, int* labeling) {
+	for (int slot = 0; slot < ps->permSize; slot++) {
+		labeling[slot] = permutation[ps->position[slot]];
+	}
+}
+
+/**
+ * Free the arrays of a prefix skipping struct
+ * @param ps The struct to free
+ */
+void freePrefixSkip(struct PrefixSkip* ps) {
+	free(ps->order);
+	free(ps->position);
+	free(ps->checkOrder);
+	free(ps->skipPosition);
+	free(ps->skipBlock);
+}
+
+#endif
@@ -0,0 +1,133 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Convert a binary result file written with --format records or --format ranks
+//back into the text output file the programs write by default, line for line.
+//
+//To compile:
+//    g++ result_convert.c -o result_convert -O3
+//
+//To run:
+//    ./result_convert output_4_3.svm
+//    ./result_convert output_4_3.svm output_4_3.txt
+//
+//Without an output file name, the .svm on the end of the input file name is
+//replaced with .txt.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "perm_index.h"
+#include "perm_rank.h"
+#include "result_file.h"
+
+#define OUTPUT_FILE_LINE_SIZE 1000
+
+void writeTextLabeling(FILE* outputFile, uint64_t number, const int* labels, int permSize,
+	int magicNumber, int orbitSize);
+
+int main(int argc, char *argv[]) {
+	if (argc != 2 && argc != 3) {
+		printf("Usage: %s input.svm [output.txt]\n", argv[0]);
+		exit(1);
+	}
+
+	char filename[OUTPUT_FILE_LINE_SIZE];
+	if (argc == 3) {
+		snprintf(filename, OUTPUT_FILE_LINE_SIZE, "%s", argv[2]);
+	} else {
+		snprintf(filename, OUTPUT_FILE_LINE_SIZE, "%s", argv[1]);
+		char* extension = strrchr(filename, '.');
+		if (extension != NULL && strcmp(extension, ".svm") == 0) {
+			*extension = '\0';
+		}
+		strncat(filename, ".txt", OUTPUT_FILE_LINE_SIZE - strlen(filename) - 1);
+	}
+
+	struct ResultFile rf = openResultFile(argv[1]);
+	struct ResultFileHeader* header = &rf.header;
+	int permSize = header->permSize;
+	int vertices = header->vertices;
+
+	FILE* outputFile = fopen(filename, "w");
+	if (outputFile == NULL) {
+		printf("An error occured creating %s.\n", filename);
+		exit(1);
+	}
+
+	//The graph parameters, time taken, and adjacency matrix
+	if (header->graphName[0] != '\0') {
+		fprintf(outputFile, "Graph: File = %.*s\n", RESULT_GRAPH_NAME, header->graphName);
+	} else {
+		fprintf(outputFile, "Graph: Cycle size = %d, connecting vertices = %d\n",
+			header->cycleSize, header->connectingVertices);
+	}
+	fprintf(outputFile, "Time taken: %f seconds\n", header->timeTaken);
+	for (int i1 = 0; i1 < vertices; i1++) {
+		for (int i2 = 0; i2 < vertices; i2++) {
+			fprintf(outputFile, "%d ", rf.matrix[i1 * vertices + i2]);
+		}
+		fprintf(outputFile, "\n");
+	}
+
+	int* labels = (int *) malloc(RESULT_CHUNK * permSize * sizeof(int));
+	if (header->encoding == RESULT_RECORDS) {
+		//Read each record straight out of the mapped file
+		for (uint64_t i1 = 0; i1 < header->count; i1++) {
+			int magicNumber;
+			readResultRecord(&rf, i1, labels, &magicNumber);
+			writeTextLabeling(outputFile, i1 + 1, labels, permSize, magicNumber, header->orbitSize);
+		}
+	} else if (header->encoding == RESULT_RANKS) {
+		//Decode the indexes a chunk at a time and unrank them together
+		std::vector<PermIndex> ranks(RESULT_CHUNK);
+		std::vector<int> magicNumbers(RESULT_CHUNK);
+		const unsigned char* pos = rf.data;
+		PermIndex rank = 0;
+		for (uint64_t chunk = 0; chunk < header->count; chunk += RESULT_CHUNK) {
+			int size = header->count - chunk < RESULT_CHUNK ? header->count - chunk : RESULT_CHUNK;
+			for (int i1 = 0; i1 < size; i1++) {
+				pos = readResultRank(pos, &rank, &magicNumbers[i1]);
+				ranks[i1] = rank;
+			}
+			unrankBatch(&ranks[0], size, permSize, labels);
+			for (int i1 = 0; i1 < size; i1++) {
+				writeTextLabeling(outputFile, chunk + i1 + 1, labels + i1 * permSize, permSize,
+					magicNumbers[i1], header->orbitSize);
+			}
+		}
+	} else {
+		printf("Unknown encoding %u in %s.\n", header->encoding, argv[1]);
+		exit(1);
+	}
+	free(labels);
+
+	fclose(outputFile);
+	closeResultFile(&rf);
+
+	char numLine[PERM_INDEX_DIGITS];
+	printf("Wrote %s labelings to %s\n", formatPermIndex(header->count, numLine), filename);
+	return 0;
+}
+
+/**
+ * Write one labeling in the format of the text output file
+ * @param outputFile The text file
+ * @param number The number of the labeling, from 1
+ * @param labels The labels
+ * @param permSize The number of labels
+ * @param magicNumber The magic number of the labeling
+ * @param orbitSize The size of its orbit, or 0 to leave it out
+ */
+void writeTextLabeling(FILE* outputFile, uint64_t number, const int* labels, int permSize,
+	int magicNumber, int orbitSize) {
+	fprintf(outputFile, "%llu: {", (unsigned long long) number);
+	for (int i1 = 0; i1 < permSize; i1++) {
+		fprintf(outputFile, i1 != permSize - 1 ? "%d, " : "%d", labels[i1]);
+	}
+	if (orbitSize > 0) {
+		fprintf(outputFile, "} Magic Number: %d Orbit size: %d\n", magicNumber, orbitSize);
+	} else {
+		fprintf(outputFile, "} Magic Number: %d\n", magicNumber);
+	}
+}
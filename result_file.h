@@ -0,0 +1,364 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//A binary format for the labelings found, much smaller and faster to write
+//than the text output file. The file starts with a fixed header holding the
+//version, the graph parameters, how the labelings are stored, how many there
+//are and the time taken, followed by the adjacency matrix as 32 bit ints.
+//The labelings start at the next multiple of 8 bytes after that.
+//
+//With RESULT_RECORDS every labeling is a record of the same size: the magic
+//number as a 32 bit int, then each label in one byte, or two if there are more
+//than 255 labels, padded to a multiple of 4 bytes. Record i is at dataOffset +
+//i * recordSize, so the file can be mapped into memory and read in place.
+//
+//With RESULT_RANKS every labeling is its permutation index instead, stored as
+//the difference from the one before, since they are written out sorted, then
+//the magic number, both as varints of 7 bits a byte with the high bit set on
+//every byte but the last. The magic number is zigzag encoded first so small
+//negative numbers stay short. This is a few bytes a labeling, but has to be
+//read from the start.
+//
+//Everything is stored in the byte order of the machine that wrote it, so a
+//file from a machine with the other byte order fails the version check.
+//result_convert.c turns a file back into the text output file.
+
+#ifndef RESULT_FILE_H
+#define RESULT_FILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+
+#include "perm_index.h"
+#include "perm_rank.h"
+
+#define RESULT_FILE_MAGIC "SVMLABEL"
+#define RESULT_FILE_VERSION 2
+#define RESULT_RECORDS 1 //Fixed size records of the labels and magic number
+#define RESULT_RANKS 2 //Varints of the sorted permutation indexes and magic numbers
+#define RESULT_CHUNK 4096 //Labelings unranked and written at a time
+#define RESULT_VARINT_BYTES 19 //Longest varint of a permutation index
+#define RESULT_GRAPH_NAME 64 //Room for the name of the graph file
+
+//Struct for the header at the start of the file
+struct ResultFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t encoding;
+
+	int32_t cycleSize;
+	int32_t connectingVertices;
+	int32_t vertices;
+	int32_t edges;
+	int32_t permSize;
+
+	//Bytes in each label and in each record, with RESULT_RECORDS
+	int32_t labelBytes;
+	int32_t recordSize;
+
+	//The size of each orbit when only the smallest labeling of each was
+	//found, or 0
+	int32_t orbitSize;
+
+	//The name of the file the graph was read from, or empty for a
+	//generated graph
+	char graphName[RESULT_GRAPH_NAME];
+
+	//Where the labelings start, how many bytes they take, and how many there
+	//are
+	uint64_t dataOffset;
+	uint64_t dataSize;
+	uint64_t count;
+
+	double timeTaken;
+};
+
+//Struct for a file being written
+struct ResultWriter {
+	FILE* file;
+	struct ResultFileHeader header;
+
+	//The last permutation index written, with RESULT_RANKS
+	PermIndex lastRank;
+
+	//The labelings being put together to write
+	std::vector<unsigned char> buffer;
+};
+
+//Struct for a file mapped into memory to read
+struct ResultFile {
+	struct ResultFileHeader header;
+	const int32_t* matrix;
+	const unsigned char* data;
+
+	void* map;
+	size_t mapSize;
+};
+
+struct ResultWriter createResultWriter(const char* filename, int encoding, int cycleSize, int connectingVertices,
+	const char* graphName, int vertices, int edges, int** matrix, int orbitSize);
+void writeResultLabelings(struct ResultWriter* rw, const PermIndex* worksIdxs, const int* magicNumbers, long count);
+void finishResultWriter(struct ResultWriter* rw, double timeTaken);
+struct ResultFile openResultFile(const char* filename);
+void readResultRecord(const struct ResultFile* rf, uint64_t i, int* labels, int* magicNumber);
+const unsigned char* readResultRank(const unsigned char* pos, PermIndex* rank, int* magicNumber);
+void closeResultFile(struct ResultFile* rf);
+unsigned char* putVarint(unsigned char* pos, PermIndex value);
+const unsigned char* getVarint(const unsigned char* pos, PermIndex* value);
+
+/**
+ * Create a file and write the header and adjacency matrix to it. The count
+ * and time taken are filled in by finishResultWriter.
+ * @param filename The name of the file
+ * @param encoding RESULT_RECORDS or RESULT_RANKS
+ * @param cycleSize The size of the cycles in the graph
+ * @param connectingVertices The number of connecting vertices in the graph
+ * @param graphName The name of the file the graph was read from, or NULL
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param orbitSize The size of each orbit when only the smallest labeling of
+ *                  each is found, or 0
+ * @return A struct for the file, finished with finishResultWriter
+ */
+struct ResultWriter createResultWriter(const char* filename, int encoding, int cycleSize, int connectingVertices,
+	const char* graphName, int vertices, int edges, int** matrix, int orbitSize) {
+	struct ResultWriter rw;
+	rw.file = fopen(filename, "wb");
+	if (rw.file == NULL) {
+		printf("An error occured creating %s.\n", filename);
+		exit(1);
+	}
+	rw.lastRank = 0;
+
+	struct ResultFileHeader* header = &rw.header;
+	memset(header, 0, sizeof(struct ResultFileHeader));
+	memcpy(header->magic, RESULT_FILE_MAGIC, 8);
+	header->version = RESULT_FILE_VERSION;
+	header->encoding = encoding;
+	header->cycleSize = cycleSize;
+	header->connectingVertices = connectingVertices;
+	if (graphName != NULL) {
+		strncpy(header->graphName, graphName, RESULT_GRAPH_NAME - 1);
+	}
+	header->vertices = vertices;
+	header->edges = edges;
+	header->permSize = vertices + edges;
+	header->labelBytes = header->permSize > 255 ? 2 : 1;
+	header->recordSize = (sizeof(int32_t) + header->permSize * header->labelBytes + 3) / 4 * 4;
+	header->orbitSize = orbitSize;
+
+	long matrixSize = (long) vertices * vertices * sizeof(int32_t);
+	header->dataOffset = (sizeof(struct ResultFileHeader) + matrixSize + 7) / 8 * 8;
+
+	fwrite(header, sizeof(struct ResultFileHeader), 1, rw.file);
+	for (int i1 = 0; i1 < vertices; i1++) {
+		for (int i2 = 0; i2 < vertices; i2++) {
+			int32_t edge = matrix[i1][i2];
+			fwrite(&edge, sizeof(int32_t), 1, rw.file);
+		}
+	}
+	long padding = header->dataOffset - sizeof(struct ResultFileHeader) - matrixSize;
+	char zeros[8] = {0};
+	fwrite(zeros, 1, padding, rw.file);
+	return rw;
+}
+
+/**
+ * Write labelings to the file, after the ones already written. With
+ * RESULT_RANKS they have to come in permutation index order.
+ * @param rw The file
+ * @param worksIdxs The permutation indexes of the labelings
+ * @param magicNumbers The magic number of each labeling
+ * @param count How many labelings
+ */
+void writeResultLabelings(struct ResultWriter* rw, const PermIndex* worksIdxs, const int* magicNumbers, long count) {
+	struct ResultFileHeader* header = &rw->header;
+	int permSize = header->permSize;
+	int* perms = (int *) malloc(RESULT_CHUNK * permSize * sizeof(int));
+
+	for (long chunk = 0; chunk < count; chunk += RESULT_CHUNK) {
+		int size = count - chunk < RESULT_CHUNK ? count - chunk : RESULT_CHUNK;
+		if (header->encoding == RESULT_RECORDS) {
+			rw->buffer.assign((long) size * header->recordSize, 0);
+			unrankBatch(worksIdxs + chunk, size, permSize, perms);
+			for (int i1 = 0; i1 < size; i1++) {
+				unsigned char* record = &rw->buffer[(long) i1 * header->recordSize];
+				int32_t magicNumber = magicNumbers[chunk + i1];
+				memcpy(record, &magicNumber, sizeof(int32_t));
+				for (int i2 = 0; i2 < permSize; i2++) {
+					int label = perms[i1 * permSize + i2];
+					if (header->labelBytes == 1) {
+						record[sizeof(int32_t) + i2] = label;
+					} else {
+						uint16_t wide = label;
+						memcpy(record + sizeof(int32_t) + 2 * i2, &wide, sizeof(uint16_t));
+					}
+				}
+			}
+		} else {
+			rw->buffer.resize((long) size * 2 * RESULT_VARINT_BYTES);
+			unsigned char* pos = &rw->buffer[0];
+			for (int i1 = 0; i1 < size; i1++) {
+				PermIndex rank = worksIdxs[chunk + i1];
+				int magicNumber = magicNumbers[chunk + i1];
+				pos = putVarint(pos, rank - rw->lastRank);
+				pos = putVarint(pos, (PermIndex) (((uint32_t) magicNumber << 1) ^ (uint32_t) (magicNumber >> 31)));
+				rw->lastRank = rank;
+			}
+			rw->buffer.resize(pos - &rw->buffer[0]);
+		}
+
+		fwrite(&rw->buffer[0], 1, rw->buffer.size(), rw->file);
+		header->dataSize += rw->buffer.size();
+		header->count += size;
+	}
+	free(perms);
+}
+
+/**
+ * Fill in the header and close the file
+ * @param rw The file
+ * @param timeTaken The time the search took
+ */
+void finishResultWriter(struct ResultWriter* rw, double timeTaken) {
+	rw->header.timeTaken = timeTaken;
+	fseek(rw->file, 0, SEEK_SET);
+	fwrite(&rw->header, sizeof(struct ResultFileHeader), 1, rw->file);
+	fclose(rw->file);
+}
+
+/**
+ * Map a file into memory to read it
+ * @param filename The name of the file
+ * @return A struct for the file, closed with closeResultFile
+ */
+struct ResultFile openResultFile(const char* filename) {
+	struct ResultFile rf;
+	int fd = open(filename, O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0) {
+		printf("An error occured opening %s.\n", filename);
+		exit(1);
+	}
+	rf.mapSize = info.st_size;
+	if (rf.mapSize < sizeof(struct ResultFileHeader)) {
+		printf("%s is too short to be a result file.\n", filename);
+		exit(1);
+	}
+	rf.map = mmap(NULL, rf.mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (rf.map == MAP_FAILED) {
+		printf("An error occured mapping %s.\n", filename);
+		exit(1);
+	}
+
+	const unsigned char* bytes = (const unsigned char *) rf.map;
+	memcpy(&rf.header, bytes, sizeof(struct ResultFileHeader));
+	if (memcmp(rf.header.magic, RESULT_FILE_MAGIC, 8) != 0) {
+		printf("%s is not a result file.\n", filename);
+		exit(1);
+	}
+	if (rf.header.version != RESULT_FILE_VERSION) {
+		printf("%s is version %u, only version %d can be read.\n", filename, rf.header.version,
+			RESULT_FILE_VERSION);
+		exit(1);
+	}
+	if (rf.header.dataOffset + rf.header.dataSize > rf.mapSize) {
+		printf("%s is cut short.\n", filename);
+		exit(1);
+	}
+
+	rf.matrix = (const int32_t *) (bytes + sizeof(struct ResultFileHeader));
+	rf.data = bytes + rf.header.dataOffset;
+	return rf;
+}
+
+/**
+ * Read one labeling of a file of records
+ * @param rf The file
+ * @param i The number of the labeling, from 0
+ * @param labels Array of permSize ints to hold the labels
+ * @param magicNumber Set to the magic number
+ */
+void readResultRecord(const struct ResultFile* rf, uint64_t i, int* labels, int* magicNumber) {
+	const unsigned char* record = rf->data + i * rf->header.recordSize;
+	int32_t magic;
+	memcpy(&magic, record, sizeof(int32_t));
+	*magicNumber = magic;
+	for (int i1 = 0; i1 < rf->header.permSize; i1++) {
+		if (rf->header.labelBytes == 1) {
+			labels[i1] = record[sizeof(int32_t) + i1];
+		} else {
+			uint16_t wide;
+			memcpy(&wide, record + sizeof(int32_t) + 2 * i1, sizeof(uint16_t));
+			labels[i1] = wide;
+		}
+	}
+}
+
+/**
+ * Read the next labeling of a file of permutation indexes
+ * @param pos Where the labeling starts
+ * @param rank The permutation index of the labeling before, set to the one
+ *             of this labeling
+ * @param magicNumber Set to the magic number
+ * @return Where the next labeling starts
+ */
+const unsigned char* readResultRank(const unsigned char* pos, PermIndex* rank, int* magicNumber) {
+	PermIndex delta, zigzag;
+	pos = getVarint(pos, &delta);
+	pos = getVarint(pos, &zigzag);
+	*rank += delta;
+	uint32_t magic = (uint32_t) zigzag;
+	*magicNumber = (int) (magic >> 1) ^ -(int) (magic & 1);
+	return pos;
+}
+
+/**
+ * Unmap a file
+ * @param rf The file
+ */
+void closeResultFile(struct ResultFile* rf) {
+	munmap(rf->map, rf->mapSize);
+}
+
+/**
+ * Write a number as a varint
+ * @param pos Where to write it
+ * @param value The number
+ * @return Where the varint ends
+ */
+unsigned char* putVarint(unsigned char* pos, PermIndex value) {
+	while (value >= 0x80) {
+		*pos++ = (unsigned char) (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	*pos++ = (unsigned char) value;
+	return pos;
+}
+
+/**
+ * Read a varint
+ * @param pos Where it starts
+ * @param value Set to the number
+ * @return Where the varint ends
+ */
+const unsigned char* getVarint(const unsigned char* pos, PermIndex* value) {
+	*value = 0;
+	int shift = 0;
+	while (*pos & 0x80) {
+		*value |= (PermIndex) (*pos++ & 0x7F) << shift;
+		shift += 7;
+	}
+	*value |= (PermIndex) *pos++ << shift;
+	return pos;
+}
+
+#endif
@@ -0,0 +1,232 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Streaming the labelings found to a writer process while the search runs,
+//instead of gathering them all on the root at the end. After each piece of
+//work a worker sends the labelings it found in that piece to the writer, in
+//batches of at most STREAM_BATCH. The sends are non-blocking from two buffers
+//that take turns, so the worker fills one while the other is on its way and
+//only waits if both are still being sent.
+//
+//Each batch starts with the start and end of its piece and a flag set on the
+//last batch of the piece, followed by the index and magic number of each
+//labeling. When the engine finds labelings in permutation index order, the
+//pieces are handed out in index order too, so the writer holds on to a piece
+//until it is complete and every piece before it has been written, then writes
+//it. The writer then only holds the pieces that finished ahead of an earlier
+//one. Otherwise the order of the pieces says nothing about the order of the
+//labelings, and the writer keeps them all and sorts them at the end.
+//
+//A worker sends an empty message with the done tag once it has no more
+//pieces, and the writer stops when every worker is done. Pieces dropped when
+//the search stops early are never sent, so whatever is still held then is
+//written out in order.
+
+#ifndef RESULT_STREAM_H
+#define RESULT_STREAM_H
+
+#include <stdlib.h>
+#include <map>
+#include <vector>
+#include <mpi.h>
+
+#include "perm_index.h"
+#include "results.h"
+
+#define STREAM_LABELINGS 103 //Tag of a batch of labelings
+#define STREAM_DONE 104 //Tag of the message saying a worker is done
+#define STREAM_BATCH 4096 //The most labelings in one batch
+#define STREAM_HEADER 3 //The piece start, end, and last flag before the labelings
+
+//Function the writer hands the labelings to, in order, along with the data
+//it was given
+typedef void (*StreamSink)(const PermIndex* worksIdxs, const int* magicNumbers, long count, void* data);
+
+//Struct for a worker's side of the stream
+struct ResultStream {
+	MPI_Comm comm;
+	int writer;
+
+	//The two buffers that take turns being filled and sent, and the one to
+	//fill next
+	PermIndex* buffers[2];
+	MPI_Request requests[2];
+	int current;
+};
+
+//Struct for a piece the writer is holding on to
+struct StreamPiece {
+	PermIndex end;
+	int complete;
+	std::vector<PermIndex> worksIdxs;
+	std::vector<int> magicNumbers;
+};
+
+struct ResultStream startResultStream(MPI_Comm comm, int writer);
+void streamResults(struct ResultStream* stream, struct Results* results, PermIndex pieceStart, PermIndex pieceEnd);
+void sendStreamBatch(struct ResultStream* stream, PermIndex pieceStart, PermIndex pieceEnd, int last,
+	const PermIndex* worksIdxs, const int* magicNumbers, int count);
+void finishResultStream(struct ResultStream* stream);
+long receiveResultStream(int numWorkers, int inOrder, MPI_Comm comm, StreamSink sink, void* data);
+long writeStreamPiece(struct StreamPiece* piece, StreamSink sink, void* data);
+
+/**
+ * Start sending labelings to the writer
+ * @param comm The processes the work is shared between
+ * @param writer The process writing out the labelings
+ * @return The worker's side of the stream, finished with finishResultStream
+ */
+struct ResultStream startResultStream(MPI_Comm comm, int writer) {
+	struct ResultStream stream;
+	stream.comm = comm;
+	stream.writer = writer;
+	for (int i1 = 0; i1 < 2; i1++) {
+		stream.buffers[i1] = (PermIndex *) malloc((STREAM_HEADER + 2 * STREAM_BATCH) * sizeof(PermIndex));
+		stream.requests[i1] = MPI_REQUEST_NULL;
+	}
+	stream.current = 0;
+	return stream;
+}
+
+/**
+ * Send the labelings found in a piece of work to the writer, and clear them
+ * from the results. The counts for each magic number are kept. A piece with
+ * no labelings is still sent so the writer knows it is done.
+ * @param stream The worker's side of the stream
+ * @param results The results of the piece
+ * @param pieceStart The first unit of the piece
+ * @param pieceEnd One past the last unit of the piece
+ */
+void streamResults(struct ResultStream* stream, struct Results* results, PermIndex pieceStart, PermIndex pieceEnd) {
+	long size = results->worksIdxs.size();
+	long sent = 0;
+	do {
+		int count = size - sent < STREAM_BATCH ? size - sent : STREAM_BATCH;
+		sendStreamBatch(stream, pieceStart, pieceEnd, sent + count == size,
+			results->worksIdxs.data() + sent, results->magicNumbers.data() + sent, count);
+		sent += count;
+	} while (sent < size);
+
+	results->worksIdxs.clear();
+	results->magicNumbers.clear();
+}
+
+/**
+ * Send one batch of labelings from the next free buffer
+ * @param stream The worker's side of the stream
+ * @param pieceStart The first unit of the piece the labelings are from
+ * @param pieceEnd One past the last unit of the piece
+ * @param last 1 if this is the last batch of the piece
+ * @param worksIdxs The permutation indexes of the labelings
+ * @param magicNumbers The magic number of each labeling
+ * @param count How many labelings, at most STREAM_BATCH
+ */
+void sendStreamBatch(struct ResultStream* stream, PermIndex pieceStart, PermIndex pieceEnd, int last,
+	const PermIndex* worksIdxs, const int* magicNumbers, int count) {
+	//Wait for the buffer's last batch to be on its way before reusing it
+	PermIndex* buffer = stream->buffers[stream->current];
+	MPI_Wait(&stream->requests[stream->current], MPI_STATUS_IGNORE);
+
+	buffer[0] = pieceStart;
+	buffer[1] = pieceEnd;
+	buffer[2] = last;
+	for (int i1 = 0; i1 < count; i1++) {
+		buffer[STREAM_HEADER + 2 * i1] = worksIdxs[i1];
+		buffer[STREAM_HEADER + 2 * i1 + 1] = (PermIndex) (long) magicNumbers[i1];
+	}
+
+	MPI_Isend(buffer, STREAM_HEADER + 2 * count, permIndexType(), stream->writer, STREAM_LABELINGS,
+		stream->comm, &stream->requests[stream->current]);
+	stream->current = 1 - stream->current;
+}
+
+/**
+ * Wait for the last batches to be sent, tell the writer this worker is done,
+ * and free the buffers
+ * @param stream The worker's side of the stream
+ */
+void finishResultStream(struct ResultStream* stream) {
+	MPI_Waitall(2, stream->requests, MPI_STATUSES_IGNORE);
+	MPI_Send(NULL, 0, permIndexType(), stream->writer, STREAM_DONE, stream->comm);
+	free(stream->buffers[0]);
+	free(stream->buffers[1]);
+}
+
+/**
+ * Take the labelings the workers send until they are all done, handing them
+ * to a sink sorted by permutation index. Run on the writer while the other
+ * processes work.
+ * @param numWorkers How many workers will send labelings
+ * @param inOrder 1 if the engine finds labelings in permutation index order,
+ *                so pieces can be written as soon as the ones before them are
+ * @param comm The processes the work is shared between
+ * @param sink The function to hand the labelings to
+ * @param data Passed on to the sink
+ * @return How many labelings were handed to the sink
+ */
+long receiveResultStream(int numWorkers, int inOrder, MPI_Comm comm, StreamSink sink, void* data) {
+	//The pieces being held, by where they start, and where the next piece to
+	//write starts. Without order every labeling goes into one piece.
+	std::map<PermIndex, struct StreamPiece> pieces;
+	PermIndex next = 0;
+	struct StreamPiece all;
+
+	PermIndex* buffer = (PermIndex *) malloc((STREAM_HEADER + 2 * STREAM_BATCH) * sizeof(PermIndex));
+	long written = 0;
+	while (numWorkers > 0) {
+		MPI_Status status;
+		MPI_Recv(buffer, STREAM_HEADER + 2 * STREAM_BATCH, permIndexType(), MPI_ANY_SOURCE, MPI_ANY_TAG,
+			comm, &status);
+		if (status.MPI_TAG == STREAM_DONE) {
+			numWorkers--;
+			continue;
+		}
+
+		int size;
+		MPI_Get_count(&status, permIndexType(), &size);
+		int count = (size - STREAM_HEADER) / 2;
+		struct StreamPiece* piece = inOrder ? &pieces[buffer[0]] : &all;
+		for (int i1 = 0; i1 < count; i1++) {
+			piece->worksIdxs.push_back(buffer[STREAM_HEADER + 2 * i1]);
+			piece->magicNumbers.push_back((int) (long) buffer[STREAM_HEADER + 2 * i1 + 1]);
+		}
+		piece->end = buffer[1];
+		piece->complete = buffer[2] != 0;
+
+		//Write every complete piece that is next in order
+		while (inOrder && !pieces.empty() && pieces.begin()->first == next && pieces.begin()->second.complete) {
+			next = pieces.begin()->second.end;
+			written += writeStreamPiece(&pieces.begin()->second, sink, data);
+			pieces.erase(pieces.begin());
+		}
+	}
+	free(buffer);
+
+	//Pieces after one that was dropped are still held
+	for (std::map<PermIndex, struct StreamPiece>::iterator it = pieces.begin(); it != pieces.end(); ++it) {
+		written += writeStreamPiece(&it->second, sink, data);
+	}
+	if (!inOrder) {
+		written += writeStreamPiece(&all, sink, data);
+	}
+	return written;
+}
+
+/**
+ * Sort the labelings of a piece and hand them to a sink
+ * @param piece The piece, left empty
+ * @param sink The function to hand the labelings to
+ * @param data Passed on to the sink
+ * @return How many labelings were handed to the sink
+ */
+long writeStreamPiece(struct StreamPiece* piece, StreamSink sink, void* data) {
+	long count = piece->worksIdxs.size();
+	if (count > 0) {
+		sortResults(piece->worksIdxs, piece->magicNumbers);
+		sink(&piece->worksIdxs[0], &piece->magicNumbers[0], count, data);
+	}
+	piece->worksIdxs.clear();
+	piece->magicNumbers.clear();
+	return count;
+}
+
+#endif
@@ -0,0 +1,392 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Helpers for the permutation indexes and magic numbers of the labelings found.
+//Engines that do not find labelings in index order sort them before output so
+//the output file is the same for every engine.
+//
+//Every engine adds the labelings it finds to a Results struct. Normally the
+//index and magic number of each one are kept to be written out. In count mode
+//nothing is kept for each labeling, only how many were found with each magic
+//number, so memory does not grow with the number found and there is nothing
+//to write out but the totals.
+//
+//A search can also stop after a number of labelings. The threads of a search
+//share one SearchLimit that counts the labelings found, and every engine polls
+//it as it goes so the threads all stop soon after the limit is reached. The
+//MPI programs share the count between processes through an MPI window on the
+//root process that each one adds to and reads now and then.
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "perm_index.h"
+
+//How many times an engine polls the limit between syncs with the other
+//processes
+#define SEARCH_POLL_INTERVAL 16384
+
+//Struct for the number of labelings to find, shared by every thread
+struct SearchLimit {
+	//How many labelings to find
+	long limit;
+
+	//How many this process has found, and 1 once the search should stop
+	std::atomic<long> found;
+	std::atomic<int> stopped;
+
+	//Shares the number found with the other processes and learns how many
+	//they found, or NULL if there are no other processes
+	void (*sync)(struct SearchLimit* limit);
+
+#ifdef MPI_VERSION
+	//The window holding the total found on the root, how much of this
+	//process's count has been added to it, and 1 while a thread is syncing
+	MPI_Win window;
+	long shared;
+	std::atomic<int> syncing;
+#endif
+};
+
+//Struct for the labelings found by one thread or process
+struct Results {
+	//The permutation index and magic number of each labeling, unless only
+	//counting
+	std::vector<PermIndex> worksIdxs;
+	std::vector<int> magicNumbers;
+
+	//1 to only count the labelings
+	int countOnly;
+
+	//How many labelings were found with each magic number, histogram[k +
+	//magicOffset] for magic number k
+	int magicOffset;
+	std::vector<PermIndex> histogram;
+
+	//The limit shared with the other threads, or NULL to find every
+	//labeling, and how many more polls until the next sync
+	struct SearchLimit* limit;
+	int pollsLeft;
+};
+
+void initSearchLimit(struct SearchLimit* limit, long count);
+struct Results createResults(int permSize, int countOnly, struct SearchLimit* limit);
+int takeResult(struct SearchLimit* limit);
+void addResult(struct Results* results, PermIndex idx, int magicNumber);
+int pollSearchLimit(struct Results* results);
+int searchStopped(struct Results* results);
+void mergeResults(struct Results* into, struct Results* from);
+void mergeSortedResults(struct Results* results, int count);
+PermIndex countResults(const PermIndex* histogram, int size);
+void writeCounts(FILE* file, const PermIndex* histogram, int size, int magicOffset, int orbitSize);
+void sortResults(PermIndex* worksIdxs, int* magicNumbers, long count);
+void sortResults(std::vector<PermIndex>& worksIdxs, std::vector<int>& magicNumbers);
+
+/**
+ * Set up a limit on the number of labelings to find, shared by threads only
+ * @param limit The limit
+ * @param count How many labelings to find
+ */
+void initSearchLimit(struct SearchLimit* limit, long count) {
+	limit->limit = count;
+	limit->found = 0;
+	limit->stopped = 0;
+	limit->sync = NULL;
+}
+
+/**
+ * Set up an empty set of results
+ * @param permSize The number of labels
+ * @param countOnly 1 to only count the labelings, 0 to keep each one
+ * @param limit The limit shared with the other threads, or NULL to find
+ *              every labeling
+ * @return The results
+ */
+struct Results createResults(int permSize, int countOnly, struct SearchLimit* limit) {
+	struct Results results;
+	results.countOnly = countOnly;
+	results.limit = limit;
+	results.pollsLeft = SEARCH_POLL_INTERVAL;
+
+	//A vertex adds or subtracts fewer than permSize labels of at most permSize
+	results.magicOffset = permSize * permSize;
+	results.histogram.assign(2 * results.magicOffset + 1, 0);
+	return results;
+}
+
+/**
+ * Add a labeling that was found
+ * @param results The results to add to
+ * @param idx The permutation index of the labeling
+ * @param magicNumber The magic number of the labeling
+ */
+inline void addResult(struct Results* results, PermIndex idx, int magicNumber) {
+	if (results->limit != NULL && !takeResult(results->limit)) {
+		return;
+	}
+	results->histogram[magicNumber + results->magicOffset]++;
+	if (!results->countOnly) {
+		results->worksIdxs.push_back(idx);
+		results->magicNumbers.push_back(magicNumber);
+	}
+}
+
+/**
+ * Count a labeling against a limit, stopping the search once the limit is
+ * reached. Other threads can still find labelings before they see it, so ones
+ * past the limit are turned away.
+ * @param limit The limit
+ * @return 1 if the labeling should be kept, 0 if the limit was already reached
+ */
+int takeResult(struct SearchLimit* limit) {
+	long found = ++limit->found;
+	if (found > limit->limit) {
+		return 0;
+	}
+	if (found == limit->limit) {
+		limit->stopped = 1;
+	}
+
+	//Let the other processes know right away
+	if (limit->sync != NULL) {
+		limit->sync(limit);
+	}
+	return 1;
+}
+
+/**
+ * Check whether the search should stop, syncing with the other processes
+ * every SEARCH_POLL_INTERVAL polls
+ * @param results The results of the thread, with a limit
+ * @return 1 if the search should stop
+ */
+int pollSearchLimit(struct Results* results) {
+	struct SearchLimit* limit = results->limit;
+	if (--results->pollsLeft == 0) {
+		results->pollsLeft = SEARCH_POLL_INTERVAL;
+		if (limit->sync != NULL && !limit->stopped) {
+			limit->sync(limit);
+		}
+	}
+	return limit->stopped.load(std::memory_order_relaxed);
+}
+
+/**
+ * Check whether enough labelings have been found, which engines call as they
+ * go. Without a limit this is only a check for NULL.
+ * @param results The results of the thread
+ * @return 1 if the search should stop
+ */
+inline int searchStopped(struct Results* results) {
+	return results->limit != NULL && pollSearchLimit(results);
+}
+
+/**
+ * Move the labelings found by one thread into the results of another
+ * @param into The results to add to
+ * @param from The results to add, left empty
+ */
+void mergeResults(struct Results* into, struct Results* from) {
+	into->worksIdxs.insert(into->worksIdxs.end(), from->worksIdxs.begin(), from->worksIdxs.end());
+	into->magicNumbers.insert(into->magicNumbers.end(), from->magicNumbers.begin(), from->magicNumbers.end());
+	from->worksIdxs.clear();
+	from->magicNumbers.clear();
+	for (size_t i1 = 0; i1 < into->histogram.size(); i1++) {
+		into->histogram[i1] += from->histogram[i1];
+		from->histogram[i1] = 0;
+	}
+}
+
+/**
+ * Merge the sorted labelings of several threads into the first one's results
+ * so they stay sorted, taking the smallest of the next labeling of each thread
+ * in turn. This gives the same order as putting them together and sorting.
+ * @param results The results of each thread, each sorted with sortResults.
+ *                All but the first are left empty.
+ * @param count How many threads
+ */
+void mergeSortedResults(struct Results* results, int count) {
+	long total = 0;
+	for (int i1 = 0; i1 < count; i1++) {
+		total += results[i1].worksIdxs.size();
+	}
+	std::vector<PermIndex> worksIdxs;
+	std::vector<int> magicNumbers;
+	worksIdxs.reserve(total);
+	magicNumbers.reserve(total);
+
+	//The next labeling of each thread, smallest first, with ties going to
+	//the smaller magic number like the sort
+	typedef std::pair<std::pair<PermIndex, int>, int> Head;
+	std::priority_queue<Head, std::vector<Head>, std::greater<Head> > heads;
+	std::vector<long> next(count, 0);
+	for (int i1 = 0; i1 < count; i1++) {
+		if (!results[i1].worksIdxs.empty()) {
+			heads.push(Head(std::make_pair(results[i1].worksIdxs[0], results[i1].magicNumbers[0]), i1));
+		}
+	}
+	while (!heads.empty()) {
+		Head head = heads.top();
+		heads.pop();
+		worksIdxs.push_back(head.first.first);
+		magicNumbers.push_back(head.first.second);
+
+		int thread = head.second;
+		long i2 = ++next[thread];
+		if (i2 < (long) results[thread].worksIdxs.size()) {
+			heads.push(Head(std::make_pair(results[thread].worksIdxs[i2], results[thread].magicNumbers[i2]), thread));
+		}
+	}
+
+	//The counts are added up as they are when merging
+	for (int i1 = 1; i1 < count; i1++) {
+		results[i1].worksIdxs.clear();
+		results[i1].magicNumbers.clear();
+		for (size_t i2 = 0; i2 < results[0].histogram.size(); i2++) {
+			results[0].histogram[i2] += results[i1].histogram[i2];
+			results[i1].histogram[i2] = 0;
+		}
+	}
+	results[0].worksIdxs.swap(worksIdxs);
+	results[0].magicNumbers.swap(magicNumbers);
+}
+
+/**
+ * Add up a histogram of magic numbers
+ * @param histogram How many labelings were found with each magic number
+ * @param size The size of the histogram
+ * @return The number of labelings
+ */
+PermIndex countResults(const PermIndex* histogram, int size) {
+	PermIndex count = 0;
+	for (int i1 = 0; i1 < size; i1++) {
+		count += histogram[i1];
+	}
+	return count;
+}
+
+/**
+ * Write out how many labelings were found in total and with each magic number
+ * @param file The file to write to
+ * @param histogram How many labelings were found with each magic number
+ * @param size The size of the histogram
+ * @param magicOffset The index in the histogram of magic number 0
+ * @param orbitSize The number of labelings each one found stands for, the
+ *                  number of automorphisms with --symmetry or 1 without
+ */
+void writeCounts(FILE* file, const PermIndex* histogram, int size, int magicOffset, int orbitSize) {
+	char countLine[PERM_INDEX_DIGITS];
+	PermIndex count = countResults(histogram, size);
+	fprintf(file, "Num worked: %s\n", formatPermIndex(count, countLine));
+	if (orbitSize > 1) {
+		fprintf(file, "Num worked including symmetric labelings: %s\n",
+			formatPermIndex(count * orbitSize, countLine));
+	}
+	for (int i1 = 0; i1 < size; i1++) {
+		if (histogram[i1] > 0) {
+			fprintf(file, "Magic Number %d: %s\n", i1 - magicOffset, formatPermIndex(histogram[i1], countLine));
+		}
+	}
+}
+
+/**
+ * Sort found labelings by permutation index, keeping each magic number with
+ * its index
+ * @param worksIdxs The permutation indexes
+ * @param magicNumbers The magic number of each labeling
+ * @param count The number of labelings
+ */
+void sortResults(PermIndex* worksIdxs, int* magicNumbers, long count) {
+	std::vector<std::pair<PermIndex, int> > pairs(count);
+	for (long i1 = 0; i1 < count; i1++) {
+		pairs[i1] = std::make_pair(worksIdxs[i1], magicNumbers[i1]);
+	}
+	std::sort(pairs.begin(), pairs.end());
+	for (long i1 = 0; i1 < count; i1++) {
+		worksIdxs[i1] = pairs[i1].first;
+		magicNumbers[i1] = pairs[i1].second;
+	}
+}
+
+/**
+ * Sort found labelings by permutation index
+ * @param worksIdxs The permutation indexes
+ * @param magicNumbers The magic number of each labeling
+ */
+void sortResults(std::vector<PermIndex>& worksIdxs, std::vector<int>& magicNumbers) {
+	if (!worksIdxs.empty()) {
+		sortResults(&worksIdxs[0], &magicNumbers[0], worksIdxs.size());
+	}
+}
+
+#ifdef MPI_VERSION
+void shareSearchLimit(struct SearchLimit* limit, MPI_Comm comm);
+void syncSearchLimit(struct SearchLimit* limit);
+void freeSearchLimit(struct SearchLimit* limit);
+
+/**
+ * Share a limit between every process, with a window on the root holding the
+ * total found. Every process has to call this.
+ * @param limit The limit, already set up with initSearchLimit
+ * @param comm The processes to share it with
+ */
+void shareSearchLimit(struct SearchLimit* limit, MPI_Comm comm) {
+	int rank;
+	MPI_Comm_rank(comm, &rank);
+
+	long* total;
+	MPI_Win_allocate(rank == 0 ? sizeof(long) : 0, sizeof(long), MPI_INFO_NULL, comm, &total, &limit->window);
+	if (rank == 0) {
+		*total = 0;
+	}
+	MPI_Barrier(comm);
+
+	//Each process adds to the total whenever it needs to, without the root
+	//taking part
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, limit->window);
+	limit->shared = 0;
+	limit->syncing = 0;
+	limit->sync = syncSearchLimit;
+}
+
+/**
+ * Add the labelings found since the last sync to the total on the root, and
+ * stop if the total has reached the limit. In a process with several threads
+ * only one syncs at a time, and a thread that finds another one syncing leaves
+ * its labelings for the next sync.
+ * @param limit The limit
+ */
+void syncSearchLimit(struct SearchLimit* limit) {
+	if (limit->syncing.exchange(1)) {
+		return;
+	}
+
+	long found = limit->found;
+	long add = found - limit->shared;
+	long total;
+	MPI_Fetch_and_op(&add, &total, MPI_LONG, 0, 0, MPI_SUM, limit->window);
+	MPI_Win_flush(0, limit->window);
+	limit->shared = found;
+	if (total + add >= limit->limit) {
+		limit->stopped = 1;
+	}
+	limit->syncing = 0;
+}
+
+/**
+ * Free the window of a shared limit. Every process has to call this.
+ * @param limit The limit
+ */
+void freeSearchLimit(struct SearchLimit* limit) {
+	MPI_Win_unlock_all(limit->window);
+	MPI_Win_free(&limit->window);
+}
+#endif
+
+#endif
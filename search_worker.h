@@ -0,0 +1,241 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//One worker running the chosen engine over units of work. Every engine splits
+//its search into a range of units: permutation indexes for the brute force,
+//SIMD, plain changes and backtracking engines (with --magic the backtracking
+//units are a magic number and an index), the labels of the first two edges
+//for the edge driven engine, magic numbers for the meet in the middle engine
+//and sets of vertex labels for the label set engine. A worker sets up its
+//engine once and can then be handed any number of ranges of units one after
+//another, which is how the OpenMP tasks and the MPI scheduler share out the
+//work.
+//
+//When the units are permutation indexes, a block of (permSize - depth)!
+//indexes starting at a multiple of the block size is every permutation with
+//the same labels in the first depth slots, so splitting the units into blocks
+//of that size hands out label prefixes.
+
+#ifndef SEARCH_WORKER_H
+#define SEARCH_WORKER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "options.h"
+#include "perm_index.h"
+#include "perm_range.h"
+#include "automorphism.h"
+#include "backtrack.h"
+#include "brute_force.h"
+#include "edge_driven.h"
+#include "family_kernels.h"
+#include "label_sets.h"
+#include "magic_range.h"
+#include "meet_in_middle.h"
+#include "plain_changes.h"
+#include "simd_eval.h"
+#include "results.h"
+
+//Struct for a worker, holding the graph, the options for the search, and the
+//engine it runs. Only the struct of the chosen engine is set up.
+struct SearchWorker {
+	int engine;
+	int vertices;
+	int edges;
+	int permSize;
+	int** matrix;
+	struct Symmetry* symmetry;
+	struct MagicRange magic;
+	int magicSplit;
+	int reorderSlots;
+	FamilyKernel kernel;
+
+	struct Backtracker bt;
+	struct EdgeSearch es;
+	struct MeetSearch ms;
+	struct PlainChanges pc;
+	struct SimdEval se;
+
+	//Where the labelings found go
+	struct Results* results;
+};
+
+struct SearchWorker createSearchWorker(struct Options* options, int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry, struct MagicRange magic, FamilyKernel kernel, struct Results* results);
+PermIndex searchUnits(struct Options* options, int vertices, int edges, struct MagicRange magic);
+PermIndex searchGrain(struct Options* options, int permSize, PermIndex numUnits, long minParts);
+PermIndex splitGrain(struct Options* options, int permSize, PermIndex grain);
+void searchWorkerRange(struct SearchWorker* sw, PermIndex start, PermIndex end);
+void freeSearchWorker(struct SearchWorker* sw);
+
+/**
+ * Set up a worker for the engine picked in the options
+ * @param options The parsed options
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param symmetry The automorphisms of the graph to only find the smallest
+ *                 labeling of each orbit, or NULL to find every labeling
+ * @param magic The magic numbers to search for
+ * @param kernel The check compiled for the graph for the brute force loop, or
+ *               NULL
+ * @param results The results to add the labelings found to
+ * @return A struct for the worker, freed with freeSearchWorker
+ */
+struct SearchWorker createSearchWorker(struct Options* options, int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry, struct MagicRange magic, FamilyKernel kernel, struct Results* results) {
+	struct SearchWorker sw;
+	sw.engine = options->engine;
+	sw.vertices = vertices;
+	sw.edges = edges;
+	sw.permSize = vertices + edges;
+	sw.matrix = matrix;
+	sw.symmetry = symmetry;
+	sw.magic = magic;
+	sw.magicSplit = options->magicSet;
+	sw.reorderSlots = options->reorderSlots;
+	sw.kernel = kernel;
+	sw.results = results;
+
+	if (sw.engine == ENGINE_BACKTRACK) {
+		sw.bt = createBacktracker(vertices, edges, matrix, symmetry);
+	} else if (sw.engine == ENGINE_EDGE) {
+		sw.es = createEdgeSearch(vertices, edges, matrix, symmetry, magic);
+	} else if (sw.engine == ENGINE_MITM) {
+		sw.ms = createMeetSearch(vertices, edges, matrix, symmetry, magic, options->memoryLimit);
+	} else if (sw.engine == ENGINE_SJT) {
+		sw.pc = createPlainChanges(vertices, edges, matrix, symmetry, magic);
+	} else if (sw.engine == ENGINE_SIMD) {
+		sw.se = createSimdEval(vertices, edges, matrix, symmetry, magic, options->scalar);
+	}
+	return sw;
+}
+
+/**
+ * The number of units of work the engine picked in the options splits its
+ * search into
+ * @param options The parsed options
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param magic The magic numbers to search for
+ * @return The number of units
+ */
+PermIndex searchUnits(struct Options* options, int vertices, int edges, struct MagicRange magic) {
+	int permSize = vertices + edges;
+	if (options->engine == ENGINE_BACKTRACK && options->magicSet) {
+		return backtrackMagicUnits(permSize, magic);
+	} else if (options->engine == ENGINE_EDGE) {
+		return edgeSearchUnits(vertices, edges);
+	} else if (options->engine == ENGINE_MITM) {
+		return meetSearchUnits(magic);
+	} else if (options->engine == ENGINE_LABELSET) {
+		return labelSetUnits(vertices, edges);
+	}
+	return factorialIndex(permSize);
+}
+
+/**
+ * Pick how many units to hand out at a time so there are at least minParts
+ * pieces of work. Permutation indexes are handed out as label prefixes, as
+ * short as gives enough pieces.
+ * @param options The parsed options
+ * @param permSize The number of labels
+ * @param numUnits The number of units
+ * @param minParts The smallest number of pieces to split the units into
+ * @return The number of units in each piece, the last one can have fewer
+ */
+PermIndex searchGrain(struct Options* options, int permSize, PermIndex numUnits, long minParts) {
+	if (options->engine == ENGINE_EDGE || options->engine == ENGINE_MITM ||
+		options->engine == ENGINE_LABELSET) {
+		PermIndex grain = numUnits / minParts;
+		return grain > 0 ? grain : 1;
+	}
+
+	//The longest block below a prefix that still gives enough of them
+	PermIndex grain = factorialIndex(permSize);
+	for (int depth = 1; depth < permSize && numUnits / grain < (PermIndex) minParts; depth++) {
+		grain /= permSize - depth + 1;
+	}
+	return grain;
+}
+
+/**
+ * Pick how many units to split a piece of work of grain units into when it
+ * is still running after the other pieces are gone. Permutation indexes are
+ * split one label deeper, so each smaller piece is still a label prefix.
+ * @param options The parsed options
+ * @param permSize The number of labels
+ * @param grain The number of units in the piece
+ * @return The number of units in each smaller piece, or grain when it cannot
+ *         be split
+ */
+PermIndex splitGrain(struct Options* options, int permSize, PermIndex grain) {
+	if (options->engine == ENGINE_EDGE || options->engine == ENGINE_MITM ||
+		options->engine == ENGINE_LABELSET) {
+		return grain > 1 ? (grain + 1) / 2 : grain;
+	}
+
+	//A block of (labels left)! indexes splits into one block for each label
+	//that can go in the next slot
+	int left = 1;
+	PermIndex block = 1;
+	while (block < grain && left < permSize) {
+		left++;
+		block *= left;
+	}
+	if (block != grain || left < 2) {
+		return grain;
+	}
+	return grain / left;
+}
+
+/**
+ * Search a range of units, adding the labelings found to the worker's results
+ * @param sw The worker
+ * @param start The first unit to search
+ * @param end One past the last unit to search
+ */
+void searchWorkerRange(struct SearchWorker* sw, PermIndex start, PermIndex end) {
+	if (sw->engine == ENGINE_BACKTRACK) {
+		if (sw->magicSplit) {
+			backtrackMagicRange(&sw->bt, sw->magic, start, end, sw->results);
+		} else {
+			backtrackRange(&sw->bt, start, end, sw->results);
+		}
+	} else if (sw->engine == ENGINE_EDGE) {
+		edgeSearchRange(&sw->es, start, end, sw->results);
+	} else if (sw->engine == ENGINE_MITM) {
+		meetSearchRange(&sw->ms, start, end, sw->results);
+	} else if (sw->engine == ENGINE_LABELSET) {
+		labelSetRange(sw->vertices, sw->edges, sw->matrix, sw->symmetry, sw->magic, start, end, sw->results);
+	} else if (sw->engine == ENGINE_SJT) {
+		plainChangesRange(&sw->pc, start, end, sw->results);
+	} else if (sw->engine == ENGINE_SIMD) {
+		struct PermRange range = createPermRange(sw->permSize, start, end);
+		simdRange(&sw->se, &range, sw->results);
+	} else {
+		struct PermRange range = createPermRange(sw->permSize, start, end);
+		bruteRange(sw->vertices, sw->edges, sw->matrix, sw->reorderSlots, sw->kernel, sw->symmetry,
+			sw->magic, &range, sw->results);
+	}
+}
+
+/**
+ * Free the engine of a worker
+ * @param sw The worker to free
+ */
+void freeSearchWorker(struct SearchWorker* sw) {
+	if (sw->engine == ENGINE_BACKTRACK) {
+		freeBacktracker(&sw->bt);
+	} else if (sw->engine == ENGINE_EDGE) {
+		freeEdgeSearch(&sw->es);
+	} else if (sw->engine == ENGINE_MITM) {
+		freeMeetSearch(&sw->ms);
+	} else if (sw->engine == ENGINE_SJT) {
+		freePlainChanges(&sw->pc);
+	} else if (sw->engine == ENGINE_SIMD) {
+		freeSimdEval(&sw->se);
+	}
+}
+
+#endif
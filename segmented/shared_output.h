@@ -0,0 +1,273 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//One output file shared by every process of the segmented search, written
+//with MPI-IO instead of a file for each process. The file starts with a
+//header of SHARED_HEADER_SIZE bytes, padded with spaces, holding the graph,
+//the number of processes, how many rounds have been written, where the index
+//of the last round is, where the next round starts, and whether the search
+//is finished.
+//
+//At each checkpoint every process formats the labelings it found into text,
+//and all of them write in one collective call. Each process writes at the end
+//of the file so far plus the bytes of the processes before it, which is a
+//prefix sum of the byte counts, so the labelings of a round are in process
+//order. Right after the labelings the root writes the index of the round,
+//with one line for each process: where its labelings start, how many bytes
+//they take, and the next permutation index it has to check. The first line
+//of the index points at the index of the round before.
+//
+//Nothing the header points at is ever written over. A round and its index go
+//after everything written so far, the file is synced, and only then is the
+//header rewritten to point at the new index. If the search is killed part way
+//through a round, the header still points at the last complete round, and the
+//partial round is written over when the search is started again.
+//
+//A search started again with the same graph and number of processes reads
+//the index of the last round to carry on from the next permutation index of
+//each process.
+
+#ifndef SHARED_OUTPUT_H
+#define SHARED_OUTPUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <mpi.h>
+
+#include "../perm_index.h"
+
+#define SHARED_HEADER_SIZE 512 //Bytes before the data, the header padded with spaces
+#define SHARED_VERSION 2 //Version of the file layout
+#define SHARED_LINE_SIZE 200 //Longest line of the header or index
+
+//Struct for the shared file
+struct SharedOutput {
+	MPI_File file;
+	MPI_Comm comm;
+	int rank;
+	int numProcs;
+	int cycleSize;
+	int connectingVertices;
+
+	//How many rounds have been written, where the index of the last one
+	//starts, or 0 before the first round, and where the next round starts
+	int rounds;
+	MPI_Offset lastIndex;
+	MPI_Offset dataEnd;
+};
+
+struct SharedOutput openSharedOutput(char* filename, int cycleSize, int connectingVertices, MPI_Comm comm,
+	PermIndex begin, PermIndex* next);
+void readSharedIndex(struct SharedOutput* out, PermIndex* nexts);
+void writeSharedRound(struct SharedOutput* out, const char* text, long long bytes, PermIndex next);
+void writeSharedHeader(struct SharedOutput* out, int finished);
+void closeSharedOutput(struct SharedOutput* out);
+
+/**
+ * Open the shared file, reading where each process left off if the search is
+ * being carried on. Every process has to call this.
+ * @param filename The name of the file
+ * @param cycleSize The size of the cycles in the graph
+ * @param connectingVertices The number of connecting vertices in the graph
+ * @param comm The processes sharing the file
+ * @param begin The first permutation index of this process
+ * @param next Set to the next permutation index this process has to check,
+ *             which is begin for a new file
+ * @return A struct for the file, closed with closeSharedOutput
+ */
+struct SharedOutput openSharedOutput(char* filename, int cycleSize, int connectingVertices, MPI_Comm comm,
+	PermIndex begin, PermIndex* next) {
+	struct SharedOutput out;
+	out.comm = comm;
+	MPI_Comm_rank(comm, &out.rank);
+	MPI_Comm_size(comm, &out.numProcs);
+	out.cycleSize = cycleSize;
+	out.connectingVertices = connectingVertices;
+	out.rounds = 0;
+	out.lastIndex = 0;
+	out.dataEnd = SHARED_HEADER_SIZE;
+
+	int returnVal = MPI_File_open(comm, filename, MPI_MODE_CREATE | MPI_MODE_RDWR, MPI_INFO_NULL, &out.file);
+	if (returnVal != MPI_SUCCESS) {
+		printf("An error occured opening %s. Terminating.\n", filename);
+		MPI_Abort(comm, returnVal);
+	}
+
+	MPI_Offset size;
+	MPI_File_get_size(out.file, &size);
+	std::vector<PermIndex> nexts;
+	if (size > 0 && out.rank == 0) {
+		nexts.resize(out.numProcs);
+		readSharedIndex(&out, &nexts[0]);
+	}
+
+	//Everyone carries on from the last round written
+	long long state[3] = {out.rounds, out.lastIndex, out.dataEnd};
+	MPI_Bcast(state, 3, MPI_LONG_LONG, 0, comm);
+	out.rounds = state[0];
+	out.lastIndex = state[1];
+	out.dataEnd = state[2];
+
+	*next = begin;
+	if (out.rounds > 0) {
+		MPI_Scatter(out.rank == 0 ? &nexts[0] : NULL, 1, permIndexType(), next, 1, permIndexType(), 0, comm);
+	}
+
+	//A new file gets its header right away
+	if (size == 0 && out.rank == 0) {
+		writeSharedHeader(&out, 0);
+	}
+	return out;
+}
+
+/**
+ * Read the header of a file being carried on, and the next permutation index
+ * of each process from the index of the last round. Run on the root.
+ * @param out The shared file
+ * @param nexts Set to the next permutation index of each process, if any
+ *              rounds have been written
+ */
+void readSharedIndex(struct SharedOutput* out, PermIndex* nexts) {
+	char header[SHARED_HEADER_SIZE + 1];
+	MPI_File_read_at(out->file, 0, header, SHARED_HEADER_SIZE, MPI_CHAR, MPI_STATUS_IGNORE);
+	header[SHARED_HEADER_SIZE] = '\0';
+
+	int version, cycleSize, connectingVertices, numProcs, rounds, finished;
+	long long lastIndex, dataEnd;
+	int read = sscanf(header,
+		"Subtractive vertex magic labelings, version %d\n"
+		"Graph: Cycle size = %d, connecting vertices = %d\n"
+		"Processes: %d\nRounds: %d\nLast index: %lld\nData end: %lld\nFinished: %d\n",
+		&version, &cycleSize, &connectingVertices, &numProcs, &rounds, &lastIndex, &dataEnd, &finished);
+	if (read != 8 || version != SHARED_VERSION) {
+		printf("The output file has an unknown header. Terminating.\n");
+		MPI_Abort(out->comm, 1);
+	}
+	if (cycleSize != out->cycleSize || connectingVertices != out->connectingVertices ||
+		numProcs != out->numProcs) {
+		printf("The output file is for a different graph or number of processes. Terminating.\n");
+		MPI_Abort(out->comm, 1);
+	}
+
+	out->rounds = rounds;
+	out->lastIndex = lastIndex;
+	out->dataEnd = dataEnd;
+	if (rounds == 0) {
+		return;
+	}
+
+	//The index of the last round runs up to where the next round starts
+	long long indexSize = dataEnd - lastIndex;
+	char* index = (char *) malloc(indexSize + 1);
+	MPI_File_read_at(out->file, lastIndex, index, indexSize, MPI_CHAR, MPI_STATUS_IGNORE);
+	index[indexSize] = '\0';
+
+	char* line = strchr(index, '\n');
+	for (int i1 = 0; i1 < numProcs; i1++) {
+		int round, process;
+		long long offset, bytes;
+		char nextLine[PERM_INDEX_DIGITS];
+		if (line == NULL || sscanf(line + 1, "Round %d process %d: offset %lld bytes %lld next %39s", &round,
+			&process, &offset, &bytes, nextLine) != 5 || round != rounds - 1 || process != i1) {
+			printf("The index of the output file is cut short. Terminating.\n");
+			MPI_Abort(out->comm, 1);
+		}
+		nexts[i1] = parsePermIndex(nextLine);
+		line = strchr(line + 1, '\n');
+	}
+	free(index);
+}
+
+/**
+ * Write the labelings of this process for one round after everything written
+ * so far, then the index of the round, then the header pointing at it. Every
+ * process has to call this, with nothing to write if it found none.
+ * @param out The shared file
+ * @param text The labelings, formatted
+ * @param bytes The length of the text
+ * @param next The next permutation index this process has to check
+ */
+void writeSharedRound(struct SharedOutput* out, const char* text, long long bytes, PermIndex next) {
+	//Each process writes after the ones before it
+	long long before = 0;
+	long long total;
+	MPI_Exscan(&bytes, &before, 1, MPI_LONG_LONG, MPI_SUM, out->comm);
+	if (out->rank == 0) {
+		before = 0;
+	}
+	MPI_Allreduce(&bytes, &total, 1, MPI_LONG_LONG, MPI_SUM, out->comm);
+
+	MPI_File_write_at_all(out->file, out->dataEnd + before, text, bytes, MPI_CHAR, MPI_STATUS_IGNORE);
+
+	//The root writes the index of the round right after its labelings
+	PermIndex entry[3] = {(PermIndex) (out->dataEnd + before), (PermIndex) bytes, next};
+	PermIndex* entries = NULL;
+	if (out->rank == 0) {
+		entries = (PermIndex *) malloc(3 * out->numProcs * sizeof(PermIndex));
+	}
+	MPI_Gather(entry, 3, permIndexType(), entries, 3, permIndexType(), 0, out->comm);
+	long long indexStart = out->dataEnd + total;
+	long long indexSize = 0;
+	if (out->rank == 0) {
+		std::vector<char> index((out->numProcs + 1) * SHARED_LINE_SIZE + 1);
+		char* line = &index[0];
+		line += sprintf(line, "Index of round %d, previous index at %lld\n", out->rounds,
+			(long long) out->lastIndex);
+		for (int i1 = 0; i1 < out->numProcs; i1++) {
+			char nextLine[PERM_INDEX_DIGITS];
+			line += sprintf(line, "Round %d process %d: offset %lld bytes %lld next %s\n", out->rounds, i1,
+				(long long) entries[3 * i1], (long long) entries[3 * i1 + 1],
+				formatPermIndex(entries[3 * i1 + 2], nextLine));
+		}
+		indexSize = line - &index[0];
+		MPI_File_write_at(out->file, indexStart, &index[0], indexSize, MPI_CHAR, MPI_STATUS_IGNORE);
+		free(entries);
+	}
+	MPI_Bcast(&indexSize, 1, MPI_LONG_LONG, 0, out->comm);
+
+	//The round and its index have to be in the file before the header points
+	//at them
+	MPI_File_sync(out->file);
+	out->rounds++;
+	out->lastIndex = indexStart;
+	out->dataEnd = indexStart + indexSize;
+	if (out->rank == 0) {
+		writeSharedHeader(out, 0);
+	}
+	MPI_File_sync(out->file);
+}
+
+/**
+ * Write the header. Run on the root.
+ * @param out The shared file
+ * @param finished 1 once every process has checked all of its permutations
+ */
+void writeSharedHeader(struct SharedOutput* out, int finished) {
+	char header[SHARED_HEADER_SIZE + 1];
+	int length = sprintf(header,
+		"Subtractive vertex magic labelings, version %d\n"
+		"Graph: Cycle size = %d, connecting vertices = %d\n"
+		"Processes: %d\nRounds: %d\nLast index: %lld\nData end: %lld\nFinished: %d\n",
+		SHARED_VERSION, out->cycleSize, out->connectingVertices, out->numProcs, out->rounds,
+		(long long) out->lastIndex, (long long) out->dataEnd, finished);
+	memset(header + length, ' ', SHARED_HEADER_SIZE - length);
+	header[SHARED_HEADER_SIZE - 1] = '\n';
+	MPI_File_write_at(out->file, 0, header, SHARED_HEADER_SIZE, MPI_CHAR, MPI_STATUS_IGNORE);
+}
+
+/**
+ * Mark the search finished and close the file, cutting off anything left
+ * after the last index by a round that was cut short. Every process has to
+ * call this.
+ * @param out The shared file
+ */
+void closeSharedOutput(struct SharedOutput* out) {
+	MPI_File_set_size(out->file, out->dataEnd);
+	if (out->rank == 0) {
+		writeSharedHeader(out, 1);
+	}
+	MPI_File_close(&out->file);
+}
+
+#endif
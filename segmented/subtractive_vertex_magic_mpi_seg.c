@@ -19,30 +19,22 @@
 #include <stdlib.h>
 #include <string.h>
 #include <mpi.h>
-#include <unistd.h>
 
 #include <algorithm>
 #include <vector>
 
+#include "../graph.h"
+#include "../incidence.h"
+#include "../perm_index.h"
+#include "../perm_range.h"
+#include "../perm_rank.h"
+#include "shared_output.h"
+
 #define OUTPUT_FILE_LINE_SIZE 1000
 #define DEVELOPMENT 1 //Print out the permutations and write to file
 #define PRODUCTION 2 //Only write the permutations to the file
 #define CHECKPOINT 1000000000
 
-struct Graph readGraph(char* filename);
-struct Graph generateGraph(int cycleSize, int connectingVertices);
-long factorial(int n);
-int* generatePermutation(long idx, int permSize);
-void printArr(int arr[], int size, int newline);
-
-//Struct for a graph, holding the number of vertices, edges, and the
-//adjacency matrix for the graph
-struct Graph {
-	int vertices;
-	int edges;
-	int** graph;
-};
-
 //Run mode. Development -> print out permutations and write to file
 //			Production -> only write permutations to file, don't print
 const int MODE = DEVELOPMENT;
@@ -74,7 +66,7 @@ int main(int argc, char *argv[]) {
 	int vertices;
 	int edges;
 	int permSize;
-	long numPermutations;
+	PermIndex numPermutations;
 
 	if (rank == 0) {
 		//Generate the graph
@@ -94,31 +86,23 @@ int main(int argc, char *argv[]) {
 		}
 
 		permSize = vertices + edges;
-		numPermutations = factorial(permSize);
+		numPermutations = factorialIndex(permSize);
 	}
 
 	//Broadcast out the graph
 	MPI_Bcast(&vertices, 1, MPI_INT, 0, MPI_COMM_WORLD);
 	MPI_Bcast(&edges, 1, MPI_INT, 0, MPI_COMM_WORLD);
 	MPI_Bcast(&permSize, 1, MPI_INT, 0, MPI_COMM_WORLD);
-	MPI_Bcast(&numPermutations, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+	MPI_Bcast(&numPermutations, 1, permIndexType(), 0, MPI_COMM_WORLD);
 
-	printf("Permutations: %ld\n", numPermutations);
+	char numLine[PERM_INDEX_DIGITS];
+	printf("Permutations: %s\n", formatPermIndex(numPermutations, numLine));
 
-	long chunkSize = numPermutations / numThreads;
-	long numDoOneMore = numPermutations - chunkSize * numThreads;
-	long start = rank * chunkSize;
-	long end = start + chunkSize;
+	struct PermRange range = splitPermRange(permSize, 0, numPermutations, numThreads, rank);
 
-	printf("Start: %ld, end: %ld\n", start, end);
-
-	if (rank < numDoOneMore) {
-		start += rank;
-		end += rank + 1;
-	} else {
-		start += numDoOneMore;
-		end += numDoOneMore;
-	}
+	char startLine[PERM_INDEX_DIGITS];
+	char endLine[PERM_INDEX_DIGITS];
+	printf("Start: %s, end: %s\n", formatPermIndex(range.begin, startLine), formatPermIndex(range.end, endLine));
 
 	if (rank != 0) {
 		matrix = (int **) malloc(vertices * sizeof(int *));
@@ -138,134 +122,86 @@ int main(int argc, char *argv[]) {
 	startTime = time(NULL);
 
 	//Init vector to hold permutation indexes that work
-	std::vector<long> worksIdxs;
+	std::vector<PermIndex> worksIdxs;
 	std::vector<int> magicNumbers;
-	
-	//Variables for segmenting execution to multiple runs
-	int c = 0;
-
-	//Check if last perm file exists, if it does get the number from it
-	long permIdx = start;
-	char lastPermFilename[OUTPUT_FILE_LINE_SIZE];
-	sprintf(lastPermFilename, "last_perm_rank%d_%d_%d.txt", rank, cycleSize, connectingVertices);
-	if (access(lastPermFilename, F_OK) != -1) {
-		//Open and read file
-		FILE* lastPermFile = fopen(lastPermFilename, "r");
-		fscanf(lastPermFile, "%ld", &permIdx);
-		fclose(lastPermFile);
-
-		permIdx++;
-	}
 
-	int* permutation = generatePermutation(permIdx, permSize);
+	//Every process writes to one shared file. If it already has some rounds
+	//in it, carry on from where each process got to.
+	char filename[OUTPUT_FILE_LINE_SIZE];
+	sprintf(filename, "output_%d_%d.txt", cycleSize, connectingVertices);
+	PermIndex next;
+	struct SharedOutput output = openSharedOutput(filename, cycleSize, connectingVertices, MPI_COMM_WORLD,
+		range.begin, &next);
+	jumpRange(&range, next - range.begin);
 
-	//printf("Starting perm idx = %ld\n", permIdx);
+	//The writes are collective, so every process goes through the same
+	//number of rounds of CHECKPOINT permutations, some of them with nothing
+	//left to check
+	long rounds = (long) ((range.end - range.index + CHECKPOINT - 1) / CHECKPOINT);
+	MPI_Allreduce(MPI_IN_PLACE, &rounds, 1, MPI_LONG, MPI_MAX, MPI_COMM_WORLD);
 
-	//Filename of output file to be appended to
-	char filename[OUTPUT_FILE_LINE_SIZE];
-	sprintf(filename, "output_rank%d_%d_%d.txt", rank, cycleSize, connectingVertices);
+	//Compile the graph into incidence lists for the checks
+	struct Incidence inc = buildIncidence(vertices, edges, matrix);
 
 	//Loop over the permutations and check the graphs
-	int magicNumber, firstVertex, works, curVertexValue, vertex, edge, vertexIn, vertexOut;
-	for (permIdx; permIdx < end; permIdx++) {
-		magicNumber = 0;
-		firstVertex = 1;
-		works = 1;
-		for (vertex = 0; vertex < vertices; vertex++) {
-			//Calculate the value for this vertex
-			curVertexValue = permutation[vertex];
-
-			//Add the values for the edges in
-			for (vertexIn = 0; vertexIn < vertices; vertexIn++) {
-				edge = matrix[vertexIn][vertex];
-				if (edge) {
-					//Add in edge value
-					curVertexValue += permutation[vertices + edge - 1];
-				}
-			}
-
-			//Subtract the values for the edges out
-			for (vertexOut = 0; vertexOut < vertices; vertexOut++) {
-				edge = matrix[vertex][vertexOut];
-				if (edge) {
-					//Subtract edge value
-					curVertexValue -= permutation[vertices + edge - 1];
-				}
+	int magicNumber, works;
+	for (long round = 0; round < rounds; round++) {
+		PermIndex roundEnd = range.end - range.index < CHECKPOINT ? range.end : range.index + CHECKPOINT;
+		for (; range.index < roundEnd; stepRange(&range)) {
+			works = checkLabeling(&inc, range.permutation, &magicNumber) == -1;
+
+			if (works) {
+				worksIdxs.push_back(range.index);
+				magicNumbers.push_back(magicNumber);
+
+				//printArr(range.permutation, permSize, 0);
+				//printf(" Magic number: %d\n", magicNumber);
 			}
+		}
 
-			if (firstVertex) {
-				//If this is the first vertex, set the magic number
-				magicNumber = curVertexValue;
-				firstVertex = 0;
-			} else {
-				//Check if this vertex value is the same as the magic number
-				if (magicNumber != curVertexValue) {
-					works = 0;
-					break;
+		printf("Writing, works idxs size = %lu\n", worksIdxs.size());
+		//Format the perms that work for the shared file
+		char* text = (char *) malloc(worksIdxs.size() * OUTPUT_FILE_LINE_SIZE + 1);
+		long long bytes = 0;
+		int* perms = (int *) malloc(worksIdxs.size() * permSize * sizeof(int));
+		unrankBatch(worksIdxs.data(), worksIdxs.size(), permSize, perms);
+		for (unsigned long i1 = 0; i1 < worksIdxs.size(); i1++) {
+			int mNum = magicNumbers[i1];
+
+			int* perm = perms + i1 * permSize;
+			//printArr(perm, permSize, 0);
+			//printf(" written Magic number: %d\n", mNum);
+
+			//Write the permutation to the output text
+			char outputLine[OUTPUT_FILE_LINE_SIZE] = "{";
+			for (int i2 = 0; i2 < permSize; i2++) {
+				char part[10]; //Shouldn't ever be bigger than 6, 10 to be save
+				if (i2 != permSize - 1) {
+					sprintf(part, "%d, ", perm[i2]);
+				} else {
+					sprintf(part, "%d", perm[i2]);
 				}
+				strcat(outputLine, part);
 			}
+			char endLine[25]; //Shouldn't be bigger than 21, 25 to be save
+			sprintf(endLine, "} Magic Number: %d\n", mNum);
+			strcat(outputLine, endLine);
+			int length = strlen(outputLine);
+			memcpy(text + bytes, outputLine, length);
+			bytes += length;
 		}
+		free(perms);
 
-		if (works) {
-			worksIdxs.push_back(permIdx);
-			magicNumbers.push_back(magicNumber);
-
-			//printArr(permutation, permSize, 0);
-			//printf(" Magic number: %d\n", magicNumber);
-		}
-
-		std::next_permutation(permutation, permutation + permSize);
-
-		c++;
-		if (c % CHECKPOINT == 0 || permIdx == end - 1) {
-			printf("Writing, works idxs size = %lu\n", worksIdxs.size());
-			//Append the perms that work to the output file
-			FILE* output = fopen(filename, "a");
-			for (unsigned long i1 = 0; i1 < worksIdxs.size(); i1++) {
-				long pIdx = worksIdxs[i1];
-				int mNum = magicNumbers[i1];
-
-				int* perm = generatePermutation(pIdx, permSize);
-				//printf("Writing perm = %ld\n", pIdx);
-				//printArr(perm, permSize, 0);
-				//printf(" written Magic number: %d\n", mNum);
-
-				//Write the permutation to the output file
-				char outputLine[OUTPUT_FILE_LINE_SIZE] = "{";
-				for (int i2 = 0; i2 < permSize; i2++) {
-					char part[10]; //Shouldn't ever be bigger than 6, 10 to be save
-					if (i2 != permSize - 1) {
-						sprintf(part, "%d, ", perm[i2]);
-					} else {
-						sprintf(part, "%d", perm[i2]);
-					}
-					strcat(outputLine, part);
-				}
-				char endLine[25]; //Shouldn't be bigger than 21, 25 to be save
-				sprintf(endLine, "} Magic Number: %d\n", mNum);
-				strcat(outputLine, endLine);
-				fputs(outputLine, output);
+		//Write every process's perms and where it got to in one go
+		writeSharedRound(&output, text, bytes, range.index);
+		free(text);
 
-				free(perm);
-			}
-			fclose(output);
-
-			//Write the last permutation that was done to a file
-			FILE* lastPermFile = fopen(lastPermFilename, "w");
-			char lastPermLine[OUTPUT_FILE_LINE_SIZE];
-			sprintf(lastPermLine, "%ld\n", permIdx);
-			fputs(lastPermLine, lastPermFile);
-			fclose(lastPermFile);
-			
-			worksIdxs.clear();
-			magicNumbers.clear();
-		}
+		worksIdxs.clear();
+		magicNumbers.clear();
 	}
 
-	//Write DONE to the end of the file so we know it's done
-	FILE* output = fopen(filename, "a");
-	fputs("DONE\n", output);
-	fclose(output);
+	//Mark the file finished so we know it's done
+	closeSharedOutput(&output);
 
 	//Wait for all to finish before the end time is calculated
 	/*
@@ -285,7 +221,7 @@ int main(int argc, char *argv[]) {
 	MPI_Gather(&size, 1, MPI_INT, sizes, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
 	//Init arrays for works idxs, magic numbers, and displacements
-	long* allWorksIdxs = NULL;
+	PermIndex* allWorksIdxs = NULL;
 	int* allMagicNumbers = NULL;
 	int* displs = NULL;
 
@@ -296,7 +232,7 @@ int main(int argc, char *argv[]) {
 		for (int i1 = 0; i1 < numThreads; i1++) {
 			numPermsWork += sizes[i1];
 		}
-		allWorksIdxs = (long *) malloc(numPermsWork * sizeof(long));
+		allWorksIdxs = (PermIndex *) malloc(numPermsWork * sizeof(PermIndex));
 		allMagicNumbers = (int *) malloc(numPermsWork * sizeof(int));
 		displs = (int *) malloc(numThreads * sizeof(int));
 
@@ -308,7 +244,7 @@ int main(int argc, char *argv[]) {
 	}
 
 	//Use gatherv to get the indices and magic numbers from each process
-	MPI_Gatherv(&worksIdxs[0], size, MPI_LONG, allWorksIdxs, sizes, displs, MPI_LONG, 0, MPI_COMM_WORLD);
+	MPI_Gatherv(&worksIdxs[0], size, permIndexType(), allWorksIdxs, sizes, displs, permIndexType(), 0, MPI_COMM_WORLD);
 	MPI_Gatherv(&magicNumbers[0], size, MPI_INT, allMagicNumbers, sizes, displs, MPI_INT, 0, MPI_COMM_WORLD);
 
 	if (rank == 0) {
@@ -343,10 +279,11 @@ int main(int argc, char *argv[]) {
 		//Write line to file
 		fputs(matrixLine, outputFile);
 
+		int* perms = (int *) malloc(numPermsWork * permSize * sizeof(int));
+		unrankBatch(allWorksIdxs, numPermsWork, permSize, perms);
 		for (int i1 = 0; i1 < numPermsWork; i1++) {
-			long permIdx = allWorksIdxs[i1];
 			int magicNumber = allMagicNumbers[i1];
-			int* perm = generatePermutation(permIdx, permSize);
+			int* perm = perms + i1 * permSize;
 			printArr(perm, permSize, 0);
 			printf(" Magic number: %d\n", magicNumber);
 
@@ -366,9 +303,8 @@ int main(int argc, char *argv[]) {
 			sprintf(end, "} Magic Number: %d\n", magicNumber);
 			strcat(outputLine, end);
 			fputs(outputLine, outputFile);
-
-			free(perm);
 		}
+		free(perms);
 
 		//Close the file
 		if (outputFile != NULL) {
@@ -393,205 +329,9 @@ int main(int argc, char *argv[]) {
 		free(matrix[i1]);
 	}
 	free(matrix);
-	free(permutation);
+	freeIncidence(&inc);
 
 	printf("Done!\n");
 
 	MPI_Finalize();
 }
-
-/**
- * Read in a graph from a given text file.
- * The first line should contain the number of vertices in the graph.
- * Then the file should contain the adjacency matrix of the graph.
- * @param filename The name of the file containing the graph data
- * @return A struct of the number of vertices, edges, and the adjacency matrix
- */
-struct Graph readGraph(char* filename) {
-	FILE *file;
-	file = fopen(filename, "r");
-
-	int vertices;
-	int edges = 0;
-
-	//First line of input file is number of vertices
-	int result = fscanf(file, "%d\n", &vertices);
-	if (result != 1) {
-		printf("An error occured getting graph size from input file.\n");
-		exit(1);
-	}
-
-	//Init adjacency matrix
-	int** graph = (int **) malloc(vertices * sizeof(int *));
-
-	char* res;
-
-	//Loop over each vertex
-	for (int i1 = 0; i1 < vertices; i1++) {
-		graph[i1] = (int *) malloc(vertices * sizeof(int));
-		size_t len;
-
-		//Read in the line
-		char line[256]; //Hope this is big enough
-		res = fgets(line, sizeof(line), file);
-		if (res == NULL) {
-			printf("An error occured reading line from input file.\n");
-			exit(1);
-		}
-
-		//Split the line into each number
-		char* part = strtok(line, " ");
-		int c = 0;
-		while (part) {
-			char numC = part[0];
-			int num = numC - '0';
-			if (num == 0) {
-				graph[i1][c] = 0;
-			} else {
-				edges += num;
-				graph[i1][c] = edges;
-			}
-			part = strtok(NULL, " ");
-			c++;
-		}
-	}
-
-	fclose(file);
-
-	struct Graph g;
-	g.vertices = vertices;
-	g.edges = edges;
-	g.graph = graph;
-
-	return g;
-}
-
-/**
- * Generates a graph of two cycles connected by some vertices
- * @param cycleSize The size of the cycles to be connected
- * @param connectingVertices The number of vertices the cycles are connected by
- * @return A struct of the number of vertices, edges, and the adjacency matrix
- */
-struct Graph generateGraph(int cycleSize, int connectingVertices) {
-	//Calculate number of vertices and generate adjacency matrix
-	int vertices = 2 * cycleSize - connectingVertices;
-	int** graph = (int **) malloc(vertices * sizeof(int *));
-	for (int i1 = 0; i1 < vertices; i1++) {
-		graph[i1] = (int *) malloc(vertices * sizeof(int));
-		for (int i2 = 0; i2 < vertices; i2++) {
-			graph[i1][i2] = 0;
-		}
-	}
-
-	//Connect the vertices
-	graph[0][cycleSize - 1] = 1;
-	graph[cycleSize - connectingVertices][vertices - 1] = cycleSize - connectingVertices + 2;
-	int edges = 2;
-	for (int i1 = 1; i1 < vertices; i1++) {
-		if (i1 < cycleSize - connectingVertices + 1) {
-			graph[i1][i1 - 1] = i1 + 1;
-		} else {
-			graph[i1][i1 - 1] = i1 + 2;
-		}
-		edges++;
-	}
-
-	struct Graph g;
-	g.vertices = vertices;
-	g.edges = edges;
-	g.graph = graph;
-
-	return g;
-}
-
-/**
- * Recursively calculate the factorial of the given number
- * @param n The number to calculate the factorial of
- * @return n!
- */
-long factorial(int n) {
-	if (n == 0) {
-		return 1;
-	}
-	if (n == 1 || n == 2) {
-		return n;
-	}
-
-	return n * factorial(n - 1);
-}
-
-int* generatePermutation(long idx, int permSize) {
-	int* permutation = (int *) malloc(permSize * sizeof(int));
-	for (int i1 = 0; i1 < permSize; i1++) {
-		permutation[i1] = i1 + 1;
-	}
-	if (idx != 0) {
-		//Generate perm for idx using factoradic numbers
-		int factoradicLength = 0;
-		long factorials[permSize];
-		long fac = 1;
-		int count = 0;
-		while (idx >= fac) {
-			fac = factorial(factoradicLength);
-			factorials[count] = fac;
-			count++;
-			factoradicLength++;
-		}
-		factoradicLength--;
-		//printf("Factoradic length: %d\n", factoradicLength);
-
-		long factoradic[permSize];
-		for (int i1 = 0; i1 < permSize; i1++) {
-			factoradic[i1] = 0;
-		}
-
-		//printf("Array inited\n");
-
-		long cur = idx;
-		count = 0;
-		for (int i1 = factoradicLength - 1; i1 >= 0; i1--) {
-			long fNum = cur / factorials[i1];
-			//printf("fNum = %ld\n", fNum);
-			factoradic[count + permSize - factoradicLength] = fNum;
-			count++;
-			cur = cur % factorials[i1];
-		}
-
-		int permutationTemp[permSize];
-		permutationTemp[0] = factoradic[0] + 1;
-		permutation[factoradic[0]] = -1;
-		for (int i1 = 1; i1 < permSize; i1++) {
-			int fNum = factoradic[i1];
-			int permIdx = 0;
-			int actualIdx = 0;
-			while (permIdx != fNum || permutation[actualIdx] == -1) {
-				if (permutation[actualIdx] != -1) {
-					permIdx++;
-				}
-				actualIdx++;
-			}
-			permutationTemp[i1] = permutation[actualIdx];
-			permutation[actualIdx] = -1;
-		}
-
-		for (int i1 = 0; i1 < permSize; i1++) {
-			permutation[i1] = permutationTemp[i1];
-		}
-	}
-
-	return permutation;
-}
-
-void printArr(int arr[], int size, int newline) {
-	printf("{");
-	for (int i1 = 0; i1 < size; i1++) {
-		printf("%d", arr[i1]);
-		if (i1 != size - 1) {
-			printf(", ");
-		}
-	}
-	printf("}");
-	if (newline) {
-		printf("\n");
-	}
-}
@@ -0,0 +1,285 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Batch evaluation of labelings with vector instructions. Consecutive
+//permutations are gathered into a batch of 32 labelings, stored slot by slot
+//as 16 bit labels so each slot is one vector of 32 lanes. The value of every
+//vertex is then worked out for all 32 labelings at once by adding and
+//subtracting the vectors of the slots in its incidence list, and compared
+//against the value of the first vertex to get a mask of the lanes that are
+//magic.
+//
+//The widest path the processor supports is picked when the search is set up:
+//AVX-512 does the whole batch in one vector, AVX2 in two halves, and the scalar
+//path checks one lane at a time and gives the same results. The batches are
+//filled in permutation index order, so the search is split up by index like
+//the brute force loop.
+
+#ifndef SIMD_EVAL_H
+#define SIMD_EVAL_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <immintrin.h>
+
+#include "incidence.h"
+#include "automorphism.h"
+#include "magic_range.h"
+#include "perm_index.h"
+#include "perm_range.h"
+#include "results.h"
+
+#define SIMD_BATCH 32
+
+#define SIMD_SCALAR 0
+#define SIMD_AVX2 1
+#define SIMD_AVX512 2
+
+//Struct for the batch search
+struct SimdEval {
+	struct Incidence inc;
+	int permSize;
+
+	//The label of each lane for each slot, lanes[slot * SIMD_BATCH + lane]
+	short* lanes;
+
+	//The path used, and its kernel, which returns a mask of the magic lanes
+	int path;
+	unsigned int (*kernel)(const struct Incidence* inc, const short* lanes);
+
+	//The automorphisms of the graph, or NULL to keep every labeling
+	struct Symmetry* symmetry;
+
+	//The magic numbers to search for
+	struct MagicRange magic;
+};
+
+struct SimdEval createSimdEval(int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry, struct MagicRange magic, int scalar);
+void simdRange(struct SimdEval* se, struct PermRange* range,
+	struct Results* results);
+unsigned int simdKernelScalar(const struct Incidence* inc, const short* lanes);
+unsigned int simdKernelAvx2(const struct Incidence* inc, const short* lanes);
+unsigned int simdKernelAvx512(const struct Incidence* inc, const short* lanes);
+const char* simdPathName(int path);
+void freeSimdEval(struct SimdEval* se);
+
+/**
+ * Set up a batch search for a graph, picking the widest path the processor
+ * supports
+ * @param vertices The number of vertices in the graph
+ * @param edges The number of edges in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param symmetry The automorphisms of the graph to only keep the smallest
+ *                 labeling of each orbit, or NULL to keep every labeling
+ * @param magic The magic numbers to search for
+ * @param scalar 1 to always use the scalar path
+ * @return A struct for the search, freed with freeSimdEval
+ */
+struct SimdEval createSimdEval(int vertices, int edges, int** matrix,
+	struct Symmetry* symmetry, struct MagicRange magic, int scalar) {
+	struct SimdEval se;
+	se.inc = buildIncidence(vertices, edges, matrix);
+	se.permSize = vertices + edges;
+	se.symmetry = symmetry;
+	se.magic = magic;
+
+	int bytes = se.permSize * SIMD_BATCH * sizeof(short);
+	se.lanes = (short *) aligned_alloc(INCIDENCE_ALIGN, bytes);
+	memset(se.lanes, 0, bytes);
+
+	__builtin_cpu_init();
+	if (!scalar && __builtin_cpu_supports("avx512bw")) {
+		se.path = SIMD_AVX512;
+		se.kernel = simdKernelAvx512;
+	} else if (!scalar && __builtin_cpu_supports("avx2")) {
+		se.path = SIMD_AVX2;
+		se.kernel = simdKernelAvx2;
+	} else {
+		se.path = SIMD_SCALAR;
+		se.kernel = simdKernelScalar;
+	}
+
+	return se;
+}
+
+/**
+ * Check every permutation left in a range in batches. The index and magic
+ * number of each labeling found are added to the results in order.
+ * @param se The search to run
+ * @param range The permutations to check, moved to the end of the range
+ * @param results The results to add the labelings found to
+ */
+void simdRange(struct SimdEval* se, struct PermRange* range,
+	struct Results* results) {
+	int permSize = se->permSize;
+	int* permutation = range->permutation;
+	int labeling[permSize];
+
+	//A lane only needs the positions that changed since it was last filled,
+	//which is at most the first change in this batch or the last one
+	int lastFrom = 0;
+	while (range->index < range->end && !searchStopped(results)) {
+		//Fill the batch with the next permutations
+		PermIndex batchStart = range->index;
+		int count = range->end - batchStart < SIMD_BATCH ? range->end - batchStart : SIMD_BATCH;
+		int from = permSize;
+		for (int lane = 0; lane < count; lane++) {
+			for (int slot = std::min(from, lastFrom); slot < permSize; slot++) {
+				se->lanes[slot * SIMD_BATCH + lane] = permutation[slot];
+			}
+			stepRange(range);
+			from = std::min(from, range->changed);
+		}
+		lastFrom = from;
+
+		//Lanes past the end of the range hold old labelings
+		unsigned int mask = se->kernel(&se->inc, se->lanes);
+		if (count < SIMD_BATCH) {
+			mask &= (1U << count) - 1;
+		}
+
+		while (mask) {
+			int lane = __builtin_ctz(mask);
+			mask &= mask - 1;
+
+			for (int slot = 0; slot < permSize; slot++) {
+				labeling[slot] = se->lanes[slot * SIMD_BATCH + lane];
+			}
+			int magicNumber = vertexValue(&se->inc, labeling, 0);
+			if (!inMagicRange(se->magic, magicNumber)) {
+				continue;
+			}
+			if (se->symmetry == NULL || isCanonical(se->symmetry, labeling)) {
+				addResult(results, batchStart + lane, magicNumber);
+			}
+		}
+	}
+}
+
+/**
+ * Find the magic lanes of a batch one lane at a time
+ * @param inc The incidence of the graph
+ * @param lanes The labels of the batch
+ * @return A mask with a bit set for each magic lane
+ */
+unsigned int simdKernelScalar(const struct Incidence* inc, const short* lanes) {
+	unsigned int mask = 0;
+	for (int lane = 0; lane < SIMD_BATCH; lane++) {
+		int magicNumber = 0;
+		int works = 1;
+		for (int vertex = 0; vertex < inc->vertices && works; vertex++) {
+			int value = 0;
+			for (int i1 = inc->start[vertex]; i1 < inc->start[vertex + 1]; i1++) {
+				value += inc->sign[i1] * lanes[inc->slot[i1] * SIMD_BATCH + lane];
+			}
+			if (vertex == 0) {
+				magicNumber = value;
+			} else if (value != magicNumber) {
+				works = 0;
+			}
+		}
+		if (works) {
+			mask |= 1U << lane;
+		}
+	}
+	return mask;
+}
+
+/**
+ * Find the magic lanes of a batch with AVX2, 16 lanes at a time
+ * @param inc The incidence of the graph
+ * @param lanes The labels of the batch
+ * @return A mask with a bit set for each magic lane
+ */
+__attribute__((target("avx2")))
+unsigned int simdKernelAvx2(const struct Incidence* inc, const short* lanes) {
+	__m256i magicLow = _mm256_setzero_si256();
+	__m256i magicHigh = _mm256_setzero_si256();
+	__m256i equalLow = _mm256_set1_epi16(-1);
+	__m256i equalHigh = _mm256_set1_epi16(-1);
+
+	for (int vertex = 0; vertex < inc->vertices; vertex++) {
+		__m256i low = _mm256_setzero_si256();
+		__m256i high = _mm256_setzero_si256();
+		for (int i1 = inc->start[vertex]; i1 < inc->minusStart[vertex]; i1++) {
+			const __m256i* slot = (const __m256i*) (lanes + inc->slot[i1] * SIMD_BATCH);
+			low = _mm256_add_epi16(low, _mm256_load_si256(slot));
+			high = _mm256_add_epi16(high, _mm256_load_si256(slot + 1));
+		}
+		for (int i1 = inc->minusStart[vertex]; i1 < inc->start[vertex + 1]; i1++) {
+			const __m256i* slot = (const __m256i*) (lanes + inc->slot[i1] * SIMD_BATCH);
+			low = _mm256_sub_epi16(low, _mm256_load_si256(slot));
+			high = _mm256_sub_epi16(high, _mm256_load_si256(slot + 1));
+		}
+
+		if (vertex == 0) {
+			magicLow = low;
+			magicHigh = high;
+		} else {
+			equalLow = _mm256_and_si256(equalLow, _mm256_cmpeq_epi16(low, magicLow));
+			equalHigh = _mm256_and_si256(equalHigh, _mm256_cmpeq_epi16(high, magicHigh));
+		}
+	}
+
+	//Pack the 16 bit lanes down to bytes, which interleaves the 128 bit
+	//halves, and put them back in order before taking the mask
+	__m256i packed = _mm256_packs_epi16(equalLow, equalHigh);
+	packed = _mm256_permute4x64_epi64(packed, 0xD8);
+	return (unsigned int) _mm256_movemask_epi8(packed);
+}
+
+/**
+ * Find the magic lanes of a batch with AVX-512, all 32 lanes at once
+ * @param inc The incidence of the graph
+ * @param lanes The labels of the batch
+ * @return A mask with a bit set for each magic lane
+ */
+__attribute__((target("avx512f,avx512bw")))
+unsigned int simdKernelAvx512(const struct Incidence* inc, const short* lanes) {
+	__m512i magic = _mm512_setzero_si512();
+	__mmask32 equal = 0xFFFFFFFF;
+
+	for (int vertex = 0; vertex < inc->vertices; vertex++) {
+		__m512i value = _mm512_setzero_si512();
+		for (int i1 = inc->start[vertex]; i1 < inc->minusStart[vertex]; i1++) {
+			value = _mm512_add_epi16(value, _mm512_load_si512(lanes + inc->slot[i1] * SIMD_BATCH));
+		}
+		for (int i1 = inc->minusStart[vertex]; i1 < inc->start[vertex + 1]; i1++) {
+			value = _mm512_sub_epi16(value, _mm512_load_si512(lanes + inc->slot[i1] * SIMD_BATCH));
+		}
+
+		if (vertex == 0) {
+			magic = value;
+		} else {
+			equal &= _mm512_cmpeq_epi16_mask(value, magic);
+		}
+	}
+
+	return (unsigned int) equal;
+}
+
+/**
+ * The name of a path, for printing out which one is used
+ * @param path The path
+ * @return The name of the path
+ */
+const char* simdPathName(int path) {
+	if (path == SIMD_AVX512) {
+		return "AVX-512";
+	} else if (path == SIMD_AVX2) {
+		return "AVX2";
+	}
+	return "scalar";
+}
+
+/**
+ * Free the arrays of a batch search
+ * @param se The search to free
+ */
+void freeSimdEval(struct SimdEval* se) {
+	freeIncidence(&se->inc);
+	free(se->lanes);
+}
+
+#endif
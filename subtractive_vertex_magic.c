@@ -11,6 +11,7 @@
 //    ./vertex_magic 3 2
 //    ./vertex_magic 3 1
 //    ./vertex_magic 4 3
+//    ./vertex_magic 4 3 --engine brute
 //    ...
 //
 //Jordan Turley, Jason Pinto, Matthew Ko
@@ -22,38 +23,47 @@
 #include <algorithm>
 #include <vector>
 
+#include "options.h"
+#include "perm_index.h"
+#include "perm_rank.h"
+#include "perm_range.h"
+#include "automorphism.h"
+#include "backtrack.h"
+#include "brute_force.h"
+#include "codegen.h"
+#include "edge_driven.h"
+#include "family_kernels.h"
+#include "graph.h"
+#include "label_sets.h"
+#include "magic_range.h"
+#include "meet_in_middle.h"
+#include "plain_changes.h"
+#include "simd_eval.h"
+#include "results.h"
+#include "result_file.h"
+
 #define OUTPUT_FILE_LINE_SIZE 1000
 #define DEVELOPMENT 1 //Print out the permutations and write to file
 #define PRODUCTION 2 //Only write the permutations to the file
 
-struct Graph readGraph(char* filename);
-struct Graph generateGraph(int cycleSize, int connectingVertices);
-long factorial(long n);
-int* generatePermutation(long idx, int permSize);
-void printArr(int arr[], int size, int newline);
-
-//Struct for a graph, holding the number of vertices, edges, and the
-//adjacency matrix for the graph
-struct Graph {
-	int vertices;
-	int edges;
-	int** graph;
-};
-
 int main(int argc, char *argv[]) {
-	int cycleSize = 4;
-	int connectingVertices = 2;
-	if (argc == 3) {
-		cycleSize = atoi(argv[1]);
-		connectingVertices = atoi(argv[2]);
+	struct Options options = parseOptions(argc, argv);
+	int cycleSize = options.cycleSize;
+	int connectingVertices = options.connectingVertices;
+
+	if (options.graphFile != NULL) {
+		printf("Graph file = %s\n", options.graphFile);
+	} else {
+		printf("Cycle size = %d\nConnecting vertices = %d\n", cycleSize, connectingVertices);
 	}
 
-	printf("Cycle size = %d\nConnecting vertices = %d\n", cycleSize, connectingVertices);
-
 	//Get the graph
-	//char* filename = (char *) "graph.txt";
-	//struct Graph graph = readGraph(filename);
-	struct Graph graph = generateGraph(cycleSize, connectingVertices);
+	struct Graph graph;
+	if (options.graphFile != NULL) {
+		graph = readGraph(options.graphFile);
+	} else {
+		graph = generateGraph(cycleSize, connectingVertices);
+	}
 	int vertices = graph.vertices;
 	int edges = graph.edges;
 	int** matrix = graph.graph;
@@ -67,348 +77,207 @@ int main(int argc, char *argv[]) {
 		printf("\n");
 	}
 
-	//Generate first permutation
 	long permSize = vertices + edges;
-	int permutation[permSize];
-	for (int i1 = 0; i1 < permSize; i1++) {
-		permutation[i1] = i1 + 1;
+	PermIndex numPermutations = factorialIndex(permSize);
+
+	char numLine[PERM_INDEX_DIGITS];
+	printf("Permutations to check: (|V| + |E|) = (%d + %d)! = %ld! = %s\n",vertices, edges, permSize,
+		formatPermIndex(numPermutations, numLine));
+
+	//Work out which magic numbers a labeling could have, limited to the ones
+	//asked for with --magic
+	struct MagicRange magic = feasibleMagicRange(vertices, edges, matrix);
+	if (options.magicSet) {
+		struct MagicRange asked = {options.magicLow, options.magicHigh};
+		magic = intersectMagicRange(magic, asked);
+	}
+	if (magicRangeSize(magic) > 0) {
+		printf("Magic numbers: %d to %d\n", magic.low, magic.high);
+	} else {
+		printf("Magic numbers: none possible\n");
 	}
-
-	long numPermutations = factorial(permSize);
-
-	printf("Permutations to check: (|V| + |E|) = (%d + %d)! = %ld! = %ld\n",vertices, edges, permSize, numPermutations);
 
 	time_t start;
 	time_t finish;
 
 	start = time(NULL);
 
-	std::vector<long> worksIdxs;
-	std::vector<int> magicNumbers;
-
-	//Loop over all permutations
-	//Try to find valid subtractive vertex magic labeling
-	int magicNumber, firstVertex, works, vertex, curVertexValue, vertexIn, edge, vertexOut;
-	for (long permIdx = 0; permIdx < numPermutations; permIdx++) {
-		magicNumber = 0;
-		firstVertex = 1;
-		works = 1;
-		for (vertex = 0; vertex < vertices; vertex++) {
-			//Calculate the value for this vertex
-			curVertexValue = permutation[vertex];
-
-			//Add the values for the edges in
-			for (vertexIn = 0; vertexIn < vertices; vertexIn++) {
-				edge = matrix[vertexIn][vertex];
-				if (edge) {
-					//Add in edge value
-					curVertexValue += permutation[vertices + edge - 1];
-				}
-			}
-
-			//Subtract the values for the edges out
-			for (vertexOut = 0; vertexOut < vertices; vertexOut++) {
-				edge = matrix[vertex][vertexOut];
-				if (edge) {
-					//Subtract edge value
-					curVertexValue -= permutation[vertices + edge - 1];
-				}
-			}
-
-			if (firstVertex) {
-				//If this is the first vertex, set the magic number
-				magicNumber = curVertexValue;
-				firstVertex = 0;
-			} else {
-				//Check if this vertex value is the same as the magic number
-				if (magicNumber != curVertexValue) {
-					works = 0;
-					break;
-				}
-			}
-		}
-		
-		if (works) {
-			worksIdxs.push_back(permIdx);
-			magicNumbers.push_back(magicNumber);
-		}
-
-		std::next_permutation(permutation, permutation + permSize);
+	//The labelings found, or only how many with each magic number, stopping
+	//early with --first or --limit
+	struct SearchLimit limit;
+	initSearchLimit(&limit, options.limit);
+	struct Results results = createResults(permSize, options.countOnly, options.limit > 0 ? &limit : NULL);
+
+	//Find the automorphisms of the graph to only search for the smallest
+	//labeling of each orbit
+	struct Symmetry symmetry;
+	struct Symmetry* symmetryPtr = NULL;
+	if (options.symmetry) {
+		symmetry = computeSymmetry(vertices, edges, matrix);
+		symmetryPtr = &symmetry;
+		printf("Automorphisms: %d\n", symmetry.order);
 	}
 
-	finish = time(NULL);
-
-	double timeTaken = difftime(finish, start);
-	printf("Time: %f seconds\n", timeTaken);
-
-	//Output file to store permutations
-	//Write the graph parameters to the first line
-	char filename[OUTPUT_FILE_LINE_SIZE];
-	sprintf(filename, "output_%d_%d.txt", cycleSize, connectingVertices);
-	FILE* outputFile = fopen(filename, "w");
-	char firstLine[OUTPUT_FILE_LINE_SIZE];
-	sprintf(firstLine, "Graph: Cycle size = %d, connecting vertices = %d\n",
-		cycleSize, connectingVertices);
-	fputs(firstLine, outputFile);
-
-	//Write the time taken to the file
-	char timeLine[OUTPUT_FILE_LINE_SIZE];
-	sprintf(timeLine, "Time taken: %f seconds\n", timeTaken);
-	fputs(timeLine, outputFile);
-
-	//Write the adjacency matrix to the output file
-	char matrixLine[OUTPUT_FILE_LINE_SIZE] = "";
-	for (int i1 = 0; i1 < vertices; i1++) {
-		for (int i2 = 0; i2 < vertices; i2++) {
-			int edge = matrix[i1][i2];
-			char part[3];
-			sprintf(part, "%d ", edge);
-			strcat(matrixLine, part);
+	//Use a check compiled for this family of graphs, or one generated for
+	//this graph, in the brute force loop when there is one
+	FamilyKernel kernel = NULL;
+	if (options.engine == ENGINE_BRUTE) {
+		if (options.codegen) {
+			kernel = compileGraphKernel(vertices, edges, matrix, options.reorderSlots);
+		} else if (options.graphFile == NULL && !options.reorderSlots) {
+			kernel = findFamilyKernel(cycleSize, connectingVertices);
 		}
-		//Add \n to the end
-		char end[2] = "\n";
-		strcat(matrixLine, end);
 	}
-	//Write line to file
-	fputs(matrixLine, outputFile);
-
-	//Print out all the permutations
-	printf("Num worked: %lu\n", worksIdxs.size());
-	for (int i1 = 0; i1 < worksIdxs.size(); i1++) {
-		long permIdx = worksIdxs[i1];
-		int magicNumber = magicNumbers[i1];
-		int* perm = generatePermutation(permIdx, permSize);
-		printArr(perm, permSize, 0);
-		printf(" Magic Number: %d\n", magicNumber);
 
-		//Write the permutation to the output file
-		char outputLine[OUTPUT_FILE_LINE_SIZE] = "";
-		sprintf(outputLine, "%d: {", (i1 + 1));
-		for (int i1 = 0; i1 < permSize; i1++) {
-			char part[10]; //Shouldn't ever be bigger than 6, 10 to be save
-			if (i1 != permSize - 1) {
-				sprintf(part, "%d, ", perm[i1]);
-			} else {
-				sprintf(part, "%d", perm[i1]);
-			}
-			strcat(outputLine, part);
+	if (options.engine == ENGINE_BACKTRACK) {
+		//Assign one slot at a time and back up as soon as a vertex misses
+		struct Backtracker bt = createBacktracker(vertices, edges, matrix, symmetryPtr);
+		if (options.magicSet) {
+			//Search for each magic number on its own
+			backtrackMagicRange(&bt, magic, 0, backtrackMagicUnits(permSize, magic), &results);
+		} else {
+			backtrackRange(&bt, 0, numPermutations, &results);
 		}
-		char end[25]; //Shouldn't be bigger than 21, 25 to be save
-		sprintf(end, "} Magic Number: %d\n", magicNumber);
-		strcat(outputLine, end);
-		fputs(outputLine, outputFile);
-		
-		free(perm);
-	}
-	printf("\n");
-
-	//Close the file
-	if (outputFile != NULL) {
-		fclose(outputFile);
+		freeBacktracker(&bt);
+	} else if (options.engine == ENGINE_EDGE) {
+		//Label the edges and derive the vertex labels
+		struct EdgeSearch es = createEdgeSearch(vertices, edges, matrix, symmetryPtr, magic);
+		edgeSearchRange(&es, 0, edgeSearchUnits(vertices, edges), &results);
+		freeEdgeSearch(&es);
+	} else if (options.engine == ENGINE_MITM) {
+		//Search both halves of the graph for each magic number and join them
+		struct MeetSearch ms = createMeetSearch(vertices, edges, matrix, symmetryPtr, magic, options.memoryLimit);
+		meetSearchRange(&ms, 0, meetSearchUnits(magic), &results);
+		freeMeetSearch(&ms);
+	} else if (options.engine == ENGINE_LABELSET) {
+		//Only search the sets of vertex labels that add up to a multiple of
+		//the number of vertices
+		labelSetRange(vertices, edges, matrix, symmetryPtr, magic, 0, labelSetUnits(vertices, edges), &results);
+	} else if (options.engine == ENGINE_SJT) {
+		//Swap two neighbouring slots at a time and only update their vertices
+		struct PlainChanges pc = createPlainChanges(vertices, edges, matrix, symmetryPtr, magic);
+		plainChangesRange(&pc, 0, numPermutations, &results);
+		freePlainChanges(&pc);
+	} else if (options.engine == ENGINE_SIMD) {
+		//Check the permutations in batches with vector instructions
+		struct SimdEval se = createSimdEval(vertices, edges, matrix, symmetryPtr, magic, options.scalar);
+		printf("SIMD path: %s\n", simdPathName(se.path));
+		struct PermRange range = createPermRange(permSize, 0, numPermutations);
+		simdRange(&se, &range, &results);
+		freeSimdEval(&se);
+	} else {
+		//Loop over all permutations
+		//Try to find valid subtractive vertex magic labeling
+		struct PermRange range = createPermRange(permSize, 0, numPermutations);
+		bruteRange(vertices, edges, matrix, options.reorderSlots, kernel, symmetryPtr, magic, &range, &results);
 	}
 
-	//Free the dynamic array for the graph
-	for (int i1 = 0; i1 < vertices; i1++) {
-		free(matrix[i1]);
-	}
-	free(matrix);
-
-	return 0;
-}
-
-/**
- * Read in a graph from a given text file.
- * The first line should contain the number of vertices in the graph.
- * Then the file should contain the adjacency matrix of the graph.
- * @param filename The name of the file containing the graph data
- * @return A struct of the number of vertices, edges, and the adjacency matrix
- */
-struct Graph readGraph(char* filename) {
-	FILE *file;
-	file = fopen(filename, "r");
-
-	int vertices;
-	int edges = 0;
+	finish = time(NULL);
 
-	//First line of input file is number of vertices
-	int result = fscanf(file, "%d\n", &vertices);
-	if (result != 1) {
-		printf("An error occured getting graph size from input file.\n");
-		exit(1);
+	if (resultsUnordered(&options)) {
+		//Labelings are not found in index order
+		sortResults(results.worksIdxs, results.magicNumbers);
 	}
 
-	printf("Result = %d\n", result);
-
-	//Init adjacency matrix
-	int** graph = (int **) malloc(vertices * sizeof(int *));
-
-	char* res;
-
-	//Loop over each vertex
-	for (int i1 = 0; i1 < vertices; i1++) {
-		graph[i1] = (int *) malloc(vertices * sizeof(int));
-
-		//Read in the line
-		char line[256]; //Hope this is big enough
-		res = fgets(line, sizeof(line), file);
-		if (res == NULL) {
-			printf("An error occured reading line from input file.\n");
-			exit(1);
-		}
+	double timeTaken = difftime(finish, start);
+	printf("Time: %f seconds\n", timeTaken);
 
-		//Split the line into each number
-		char* part = strtok(line, " ");
-		int c = 0;
-		while (part) {
-			char numC = part[0];
-			int num = numC - '0';
-			if (num == 0) {
-				graph[i1][c] = 0;
-			} else {
-				edges += num;
-				graph[i1][c] = edges;
+	//Write the labelings to a binary file instead of the text one when asked
+	if (options.format != FORMAT_TEXT && !options.countOnly) {
+		char binaryName[OUTPUT_FILE_LINE_SIZE];
+		outputFilename(&options, "svm", binaryName, OUTPUT_FILE_LINE_SIZE);
+		struct ResultWriter writer = createResultWriter(binaryName, options.format, cycleSize, connectingVertices,
+			graphFileName(&options), vertices, edges, matrix, options.symmetry ? symmetry.order : 0);
+		writeResultLabelings(&writer, results.worksIdxs.data(), results.magicNumbers.data(), results.worksIdxs.size());
+		finishResultWriter(&writer, timeTaken);
+		printf("Num worked: %lu\n", results.worksIdxs.size());
+	} else {
+		//Output file to store permutations
+		//Write the graph parameters to the first line
+		char filename[OUTPUT_FILE_LINE_SIZE];
+		outputFilename(&options, "txt", filename, OUTPUT_FILE_LINE_SIZE);
+		FILE* outputFile = fopen(filename, "w");
+		char firstLine[OUTPUT_FILE_LINE_SIZE];
+		outputGraphLine(&options, firstLine, OUTPUT_FILE_LINE_SIZE);
+		fputs(firstLine, outputFile);
+
+		//Write the time taken to the file
+		char timeLine[OUTPUT_FILE_LINE_SIZE];
+		sprintf(timeLine, "Time taken: %f seconds\n", timeTaken);
+		fputs(timeLine, outputFile);
+
+		//Write the adjacency matrix to the output file
+		char matrixLine[OUTPUT_FILE_LINE_SIZE] = "";
+		for (int i1 = 0; i1 < vertices; i1++) {
+			for (int i2 = 0; i2 < vertices; i2++) {
+				int edge = matrix[i1][i2];
+				char part[3];
+				sprintf(part, "%d ", edge);
+				strcat(matrixLine, part);
 			}
-			part = strtok(NULL, " ");
-			c++;
+			//Add \n to the end
+			char end[2] = "\n";
+			strcat(matrixLine, end);
 		}
-	}
-
-	fclose(file);
-
-	struct Graph g;
-	g.vertices = vertices;
-	g.edges = edges;
-	g.graph = graph;
-
-	return g;
-}
-
-/**
- * Generates a graph of two cycles connected by some vertices
- * @param cycleSize The size of the cycles to be connected
- * @param connectingVertices The number of vertices the cycles are connected by
- * @return A struct of the number of vertices, edges, and the adjacency matrix
- */
-struct Graph generateGraph(int cycleSize, int connectingVertices) {
-	//Calculate number of vertices and generate adjacency matrix
-	int vertices = 2 * cycleSize - connectingVertices;
-	int** graph = (int **) malloc(vertices * sizeof(int *));
-	for (int i1 = 0; i1 < vertices; i1++) {
-		graph[i1] = (int *) malloc(vertices * sizeof(int));
-		for (int i2 = 0; i2 < vertices; i2++) {
-			graph[i1][i2] = 0;
-		}
-	}
-
-	//Connect the vertices
-	graph[0][cycleSize - 1] = 1;
-	graph[cycleSize - connectingVertices][vertices - 1] = cycleSize - connectingVertices + 2;
-	int edges = 2;
-	for (int i1 = 1; i1 < vertices; i1++) {
-		if (i1 < cycleSize - connectingVertices + 1) {
-			graph[i1][i1 - 1] = i1 + 1;
+		//Write line to file
+		fputs(matrixLine, outputFile);
+
+		//Print out all the permutations, or only the totals when counting
+		std::vector<PermIndex>& worksIdxs = results.worksIdxs;
+		std::vector<int>& magicNumbers = results.magicNumbers;
+		if (options.countOnly) {
+			int orbitSize = options.symmetry ? symmetry.order : 1;
+			writeCounts(stdout, &results.histogram[0], results.histogram.size(), results.magicOffset, orbitSize);
+			writeCounts(outputFile, &results.histogram[0], results.histogram.size(), results.magicOffset, orbitSize);
 		} else {
-			graph[i1][i1 - 1] = i1 + 2;
-		}
-		edges++;
-	}
-
-	struct Graph g;
-	g.vertices = vertices;
-	g.edges = edges;
-	g.graph = graph;
-
-	return g;
-}
-
-/**
- * Recursively calculate the factorial of the given number
- * @param n The number to calculate the factorial of
- * @return n!
- */
-long factorial(long n) {
-	if (n == 0) {
-		return 1;
-	}
-	if (n == 1 || n == 2) {
-		return n;
-	}
-
-	return n * factorial(n - 1);
-}
-
-int* generatePermutation(long idx, int permSize) {
-	int* permutation = (int *) malloc(permSize * sizeof(int));
-	for (int i1 = 0; i1 < permSize; i1++) {
-		permutation[i1] = i1 + 1;
-	}
-	if (idx != 0) {
-		//Generate perm for idx using factoradic numbers
-		int factoradicLength = 0;
-		long factorials[permSize];
-		long fac = 1;
-		int count = 0;
-		while (idx >= fac) {
-			fac = factorial(factoradicLength);
-			factorials[count] = fac;
-			count++;
-			factoradicLength++;
-		}
-		factoradicLength--;
-		//printf("Factoradic length: %d\n", factoradicLength);
-
-		long factoradic[permSize];
-		for (int i1 = 0; i1 < permSize; i1++) {
-			factoradic[i1] = 0;
-		}
-
-		//printf("Array inited\n");
-
-		long cur = idx;
-		count = 0;
-		for (int i1 = factoradicLength - 1; i1 >= 0; i1--) {
-			long fNum = cur / factorials[i1];
-			//printf("fNum = %ld\n", fNum);
-			factoradic[count + permSize - factoradicLength] = fNum;
-			count++;
-			cur = cur % factorials[i1];
+			printf("Num worked: %lu\n", worksIdxs.size());
+			if (options.symmetry) {
+				printf("Num worked including symmetric labelings: %lu\n", worksIdxs.size() * symmetry.order);
+			}
 		}
-
-		int permutationTemp[permSize];
-		permutationTemp[0] = factoradic[0] + 1;
-		permutation[factoradic[0]] = -1;
-		for (int i1 = 1; i1 < permSize; i1++) {
-			int fNum = factoradic[i1];
-			int permIdx = 0;
-			int actualIdx = 0;
-			while (permIdx != fNum || permutation[actualIdx] == -1) {
-				if (permutation[actualIdx] != -1) {
-					permIdx++;
+		int* perms = (int *) malloc(worksIdxs.size() * permSize * sizeof(int));
+		unrankBatch(worksIdxs.data(), worksIdxs.size(), permSize, perms);
+		for (int i1 = 0; i1 < worksIdxs.size(); i1++) {
+			int magicNumber = magicNumbers[i1];
+			int* perm = perms + i1 * permSize;
+			printArr(perm, permSize, 0);
+			printf(" Magic Number: %d\n", magicNumber);
+
+			//Write the permutation to the output file
+			char outputLine[OUTPUT_FILE_LINE_SIZE] = "";
+			sprintf(outputLine, "%d: {", (i1 + 1));
+			for (int i1 = 0; i1 < permSize; i1++) {
+				char part[10]; //Shouldn't ever be bigger than 6, 10 to be save
+				if (i1 != permSize - 1) {
+					sprintf(part, "%d, ", perm[i1]);
+				} else {
+					sprintf(part, "%d", perm[i1]);
 				}
-				actualIdx++;
+				strcat(outputLine, part);
+			}
+			char end[50]; //Shouldn't be bigger than 40, 50 to be safe
+			if (options.symmetry) {
+				sprintf(end, "} Magic Number: %d Orbit size: %d\n", magicNumber, symmetry.order);
+			} else {
+				sprintf(end, "} Magic Number: %d\n", magicNumber);
 			}
-			permutationTemp[i1] = permutation[actualIdx];
-			permutation[actualIdx] = -1;
+			strcat(outputLine, end);
+			fputs(outputLine, outputFile);
 		}
+		free(perms);
+		printf("\n");
 
-		for (int i1 = 0; i1 < permSize; i1++) {
-			permutation[i1] = permutationTemp[i1];
+		//Close the file
+		if (outputFile != NULL) {
+			fclose(outputFile);
 		}
 	}
 
-	return permutation;
-}
-
-void printArr(int arr[], int size, int newline) {
-	printf("{");
-	for (int i1 = 0; i1 < size; i1++) {
-		printf("%d", arr[i1]);
-		if (i1 != size - 1) {
-			printf(", ");
-		}
-	}
-	printf("}");
-	if (newline) {
-		printf("\n");
+	//Free the dynamic array for the graph
+	for (int i1 = 0; i1 < vertices; i1++) {
+		free(matrix[i1]);
 	}
+	free(matrix);
+
+	return 0;
 }
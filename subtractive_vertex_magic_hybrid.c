@@ -0,0 +1,424 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Read in a graph from a text file or generate a graph of two cycles joined by
+//a certain number of vertices and try to find subtractive vertex magic
+//labelings of the graph.
+//
+//Hybrid of the MPI and OpenMP versions: one process per node, or per NUMA
+//domain, with a team of threads in each. The root hands out pieces of work to
+//the processes, each process splits its pieces into tasks for its threads, and
+//the labelings of the threads are put together before the one gather to the
+//root. Each process holds one copy of the graph for all of its threads.
+//
+//To compile:
+//    mpic++ subtractive_vertex_magic_hybrid.c -o vertex_magic_hybrid -O3 -fopenmp
+//
+//To run:
+//    OMP_NUM_THREADS=[threads per process] mpirun -n [num nodes] -machinefile [machinefile] --map-by node --bind-to none ./vertex_magic_hybrid 3 2
+//    OMP_NUM_THREADS=[threads per process] mpirun -n [num nodes] -machinefile [machinefile] --map-by node --bind-to none ./vertex_magic_hybrid 4 3
+//    ...
+//
+//Jordan Turley, Jason Pinto, Matthew Ko
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include <omp.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "options.h"
+#include "perm_index.h"
+#include "perm_rank.h"
+#include "perm_range.h"
+#include "automorphism.h"
+#include "codegen.h"
+#include "family_kernels.h"
+#include "graph.h"
+#include "magic_range.h"
+#include "search_worker.h"
+#include "simd_eval.h"
+#include "results.h"
+#include "result_file.h"
+#include "text_output.h"
+#include "work_scheduler.h"
+
+#define OUTPUT_FILE_LINE_SIZE 1000
+#define PIECES_PER_WORKER 64 //Pieces of work for each process before their rates are known
+#define TASKS_PER_THREAD 8 //Tasks for each thread in each piece of work
+
+void searchPiece(struct SearchWorker** workers, struct Results* results, PermIndex start, PermIndex end,
+	PermIndex grain);
+
+int main(int argc, char *argv[]) {
+	struct Options options = parseOptions(argc, argv);
+	int cycleSize = options.cycleSize;
+	int connectingVertices = options.connectingVertices;
+
+	if (options.graphFile != NULL) {
+		printf("Graph file = %s\n", options.graphFile);
+	} else {
+		printf("Cycle size = %d\nConnecting vertices = %d\n", cycleSize, connectingVertices);
+	}
+
+	//Any thread can call MPI: on the root one hands out work while another
+	//asks for it, and every thread adds to the shared limit
+	int returnVal;
+	int provided;
+	returnVal = MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+	if (returnVal != MPI_SUCCESS) {
+		printf("An error occured during MPI_Init_thread. Terminating.\n");
+		MPI_Abort(MPI_COMM_WORLD, returnVal);
+	}
+
+	int rank;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	int numProcs;
+	MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
+
+	if (numProcs > 1 && provided < MPI_THREAD_MULTIPLE) {
+		printf("MPI does not support calls from more than one thread. Terminating.\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+
+	int numThreads = omp_get_max_threads();
+
+	int** matrix;
+	int vertices;
+	int edges;
+	int permSize;
+	PermIndex numPermutations;
+
+	if (rank == 0) {
+		//Generate the graph
+		struct Graph graph;
+		if (options.graphFile != NULL) {
+			graph = readGraph(options.graphFile);
+		} else {
+			graph = generateGraph(cycleSize, connectingVertices);
+		}
+		vertices = graph.vertices;
+		edges = graph.edges;
+		matrix = graph.graph;
+
+		//Print out graph
+		printf("%d, %d\n", vertices, edges);
+		for (int i1 = 0; i1 < vertices; i1++) {
+			for (int i2 = 0; i2 < vertices; i2++) {
+				printf("%d ", matrix[i1][i2]);
+			}
+			printf("\n");
+		}
+
+		permSize = vertices + edges;
+		numPermutations = factorialIndex(permSize);
+	}
+
+	//Broadcast out the graph
+	MPI_Bcast(&vertices, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Bcast(&edges, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Bcast(&permSize, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Bcast(&numPermutations, 1, permIndexType(), 0, MPI_COMM_WORLD);
+
+	char numLine[PERM_INDEX_DIGITS];
+	printf("Permutations: %s\n", formatPermIndex(numPermutations, numLine));
+
+	if (rank != 0) {
+		matrix = (int **) malloc(vertices * sizeof(int *));
+		for (int i1 = 0; i1 < vertices; i1++) {
+			matrix[i1] = (int *) malloc(vertices * sizeof(int));
+		}
+	}
+
+	//Loop over and broadcast each row of the matrix
+	for (int i1 = 0; i1 < vertices; i1++) {
+		MPI_Bcast(matrix[i1], vertices, MPI_INT, 0, MPI_COMM_WORLD);
+	}
+
+	//Work out which magic numbers a labeling could have, limited to the ones
+	//asked for with --magic
+	struct MagicRange magic = feasibleMagicRange(vertices, edges, matrix);
+	if (options.magicSet) {
+		struct MagicRange asked = {options.magicLow, options.magicHigh};
+		magic = intersectMagicRange(magic, asked);
+	}
+	if (rank == 0) {
+		if (magicRangeSize(magic) > 0) {
+			printf("Magic numbers: %d to %d\n", magic.low, magic.high);
+		} else {
+			printf("Magic numbers: none possible\n");
+		}
+	}
+	printf("Process %d threads: %d\n", rank, numThreads);
+
+	//The units of work the engine splits its search into
+	PermIndex numUnits = searchUnits(&options, vertices, edges, magic);
+
+	//Find the automorphisms of the graph to only search for the smallest
+	//labeling of each orbit
+	struct Symmetry symmetry;
+	struct Symmetry* symmetryPtr = NULL;
+	if (options.symmetry) {
+		symmetry = computeSymmetry(vertices, edges, matrix);
+		symmetryPtr = &symmetry;
+		printf("Automorphisms: %d\n", symmetry.order);
+	}
+
+	//Use a check compiled for this family of graphs, or one generated for
+	//this graph, in the brute force loop when there is one. The first
+	//process builds a generated check and the rest load it from the cache.
+	FamilyKernel kernel = NULL;
+	if (options.engine == ENGINE_BRUTE) {
+		if (options.codegen) {
+			if (rank == 0) {
+				kernel = compileGraphKernel(vertices, edges, matrix, options.reorderSlots);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+			if (rank != 0) {
+				kernel = compileGraphKernel(vertices, edges, matrix, options.reorderSlots);
+			}
+		} else if (options.graphFile == NULL && !options.reorderSlots) {
+			kernel = findFamilyKernel(cycleSize, connectingVertices);
+		}
+	}
+
+	time_t startTime;
+	time_t finishTime;
+
+	startTime = time(NULL);
+
+	//The labelings each thread finds, or only how many with each magic number.
+	//With --first or --limit every thread of every process shares the number
+	//found, and all of them stop once the limit is reached.
+	struct SearchLimit limit;
+	initSearchLimit(&limit, options.limit);
+	if (options.limit > 0) {
+		shareSearchLimit(&limit, MPI_COMM_WORLD);
+	}
+	std::vector<struct Results> threadResults(numThreads,
+		createResults(permSize, options.countOnly, options.limit > 0 ? &limit : NULL));
+	std::vector<struct SearchWorker*> workers(numThreads);
+
+	//Each thread's engine gets an equal share of the memory for the meet in
+	//the middle records
+	options.memoryLimit /= numThreads;
+
+	int scheduling = numProcs > 1;
+
+	#pragma omp parallel num_threads(numThreads)
+	{
+		//One thread of each process asks for work and makes tasks out of it.
+		//On the root the first thread hands out the work, so the second one
+		//asks for the root's share, and a root with one thread only hands out
+		//work. The runtime can give fewer threads than asked for, so this goes
+		//by the team there is.
+		int teamSize = omp_get_num_threads();
+		int feeder = rank == 0 && scheduling && teamSize > 1 ? 1 : 0;
+
+		//Each thread sets up its own engine, which runs whichever tasks the
+		//thread picks up
+		int id = omp_get_thread_num();
+		struct SearchWorker worker = createSearchWorker(&options, vertices, edges, matrix,
+			symmetryPtr, magic, kernel, &threadResults[id]);
+		if (rank == 0 && id == 0 && options.engine == ENGINE_SIMD) {
+			printf("SIMD path: %s\n", simdPathName(worker.se.path));
+		}
+		workers[id] = &worker;
+		#pragma omp barrier
+
+		if (rank == 0 && id == 0 && scheduling) {
+			//Only the root's team size matters, since it decides whether the
+			//root asks for work too
+			int numWorkers = teamSize > 1 ? numProcs : numProcs - 1;
+			PermIndex firstPiece = searchGrain(&options, permSize, numUnits,
+				(long) numWorkers * PIECES_PER_WORKER);
+			scheduleWork(numUnits, firstPiece, numWorkers, MPI_COMM_WORLD);
+		} else if (id == feeder && !scheduling) {
+			//With one process there is nobody to ask for work, so the whole
+			//search is split into tasks like the OpenMP version
+			PermIndex grain = searchGrain(&options, permSize, numUnits, (long) teamSize * TASKS_PER_THREAD);
+			searchPiece(&workers[0], &threadResults[0], 0, numUnits, grain);
+		} else if (id == feeder) {
+			//Work on pieces for the whole process until the root runs out, or
+			//enough labelings are found
+			struct WorkFeed feed = startWorkFeed(MPI_COMM_WORLD, 0);
+			PermIndex start, end;
+			while (nextWork(&feed, searchStopped(&threadResults[id]), &start, &end)) {
+				PermIndex grain = (end - start) / (teamSize * TASKS_PER_THREAD);
+				searchPiece(&workers[0], &threadResults[0], start, end, grain > 0 ? grain : 1);
+			}
+		}
+
+		//The threads waiting here run the tasks
+		#pragma omp barrier
+		freeSearchWorker(&worker);
+	}
+
+	//Put the labelings of the threads together so each process sends them
+	//in one message
+	for (int thread = 1; thread < numThreads; thread++) {
+		mergeResults(&threadResults[0], &threadResults[thread]);
+	}
+	struct Results& results = threadResults[0];
+
+	//Wait for all to finish before the end time is calculated
+	MPI_Barrier(MPI_COMM_WORLD);
+	if (options.limit > 0) {
+		freeSearchLimit(&limit);
+	}
+
+	finishTime = time(NULL);
+	double timeTaken = difftime(finishTime, startTime);
+
+	//Add up the counts of every process on the root
+	PermIndex* allCounts = NULL;
+	if (rank == 0) {
+		allCounts = (PermIndex *) malloc(results.histogram.size() * sizeof(PermIndex));
+	}
+	MPI_Reduce(&results.histogram[0], allCounts, results.histogram.size(), permIndexType(),
+		permIndexSum(), 0, MPI_COMM_WORLD);
+
+	//Do a gather to get the sizes of each of the arrays
+	std::vector<PermIndex>& worksIdxs = results.worksIdxs;
+	std::vector<int>& magicNumbers = results.magicNumbers;
+	int size = worksIdxs.size();
+	int* sizes = NULL;
+	if (rank == 0) {
+		sizes = (int *) malloc(numProcs * sizeof(int));
+	}
+
+	//Gather the sizes to the root
+	MPI_Gather(&size, 1, MPI_INT, sizes, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+	//Init arrays for works idxs, magic numbers, and displacements
+	PermIndex* allWorksIdxs = NULL;
+	int* allMagicNumbers = NULL;
+	int* displs = NULL;
+
+	//Calculate total number of perms that work and displacement array
+	int numPermsWork = 0;
+	if (rank == 0) {
+		for (int i1 = 0; i1 < numProcs; i1++) {
+			numPermsWork += sizes[i1];
+		}
+		allWorksIdxs = (PermIndex *) malloc(numPermsWork * sizeof(PermIndex));
+		allMagicNumbers = (int *) malloc(numPermsWork * sizeof(int));
+		displs = (int *) malloc(numProcs * sizeof(int));
+
+		int displ = 0;
+		for (int i1 = 0; i1 < numProcs; i1++) {
+			displs[i1] = displ;
+			displ += sizes[i1];
+		}
+	}
+
+	//Use gatherv to get the indices and magic numbers from each process
+	MPI_Gatherv(&worksIdxs[0], size, permIndexType(), allWorksIdxs, sizes, displs, permIndexType(), 0, MPI_COMM_WORLD);
+	MPI_Gatherv(&magicNumbers[0], size, MPI_INT, allMagicNumbers, sizes, displs, MPI_INT, 0, MPI_COMM_WORLD);
+
+	if (rank == 0) {
+		//Pieces of work are handed out in any order, and some engines do not
+		//find labelings in index order either
+		sortResults(allWorksIdxs, allMagicNumbers, numPermsWork);
+	}
+
+	//Processes can each find some before they hear the limit was reached,
+	//so only keep the first ones
+	if (rank == 0 && options.limit > 0 && numPermsWork > options.limit) {
+		numPermsWork = options.limit;
+	}
+
+	//Write the labelings to a binary file instead of the text one when asked
+	if (rank == 0 && options.format != FORMAT_TEXT && !options.countOnly) {
+		char binaryName[OUTPUT_FILE_LINE_SIZE];
+		outputFilename(&options, "svm", binaryName, OUTPUT_FILE_LINE_SIZE);
+		struct ResultWriter writer = createResultWriter(binaryName, options.format, cycleSize, connectingVertices,
+			graphFileName(&options), vertices, edges, matrix, options.symmetry ? symmetry.order : 0);
+		writeResultLabelings(&writer, allWorksIdxs, allMagicNumbers, numPermsWork);
+		finishResultWriter(&writer, timeTaken);
+		printf("Num worked: %d\n", numPermsWork);
+	} else if (rank == 0) {
+		//Output file to store permutations
+		//Write the graph parameters to the first line
+		char filename[OUTPUT_FILE_LINE_SIZE];
+		outputFilename(&options, "txt", filename, OUTPUT_FILE_LINE_SIZE);
+		FILE* outputFile = fopen(filename, "w");
+		char firstLine[OUTPUT_FILE_LINE_SIZE];
+		outputGraphLine(&options, firstLine, OUTPUT_FILE_LINE_SIZE);
+		fputs(firstLine, outputFile);
+
+		//Write the time taken to the file
+		char timeLine[OUTPUT_FILE_LINE_SIZE];
+		sprintf(timeLine, "Time taken: %f seconds\n", timeTaken);
+		fputs(timeLine, outputFile);
+
+		//Write the adjacency matrix to the output file
+		char matrixLine[OUTPUT_FILE_LINE_SIZE] = "";
+		for (int i1 = 0; i1 < vertices; i1++) {
+			for (int i2 = 0; i2 < vertices; i2++) {
+				int edge = matrix[i1][i2];
+				char part[3];
+				sprintf(part, "%d ", edge);
+				strcat(matrixLine, part);
+			}
+			//Add \n to the end
+			char end[2] = "\n";
+			strcat(matrixLine, end);
+		}
+		//Write line to file
+		fputs(matrixLine, outputFile);
+
+		if (options.countOnly) {
+			int orbitSize = options.symmetry ? symmetry.order : 1;
+			writeCounts(stdout, allCounts, results.histogram.size(), results.magicOffset, orbitSize);
+			writeCounts(outputFile, allCounts, results.histogram.size(), results.magicOffset, orbitSize);
+		}
+
+		//Format the labelings on every thread while another writes them out
+		writeTextLabelings(outputFile, allWorksIdxs, allMagicNumbers, numPermsWork, permSize,
+			options.symmetry ? symmetry.order : 0, omp_get_max_threads());
+
+		//Close the file
+		if (outputFile != NULL) {
+			fclose(outputFile);
+		}
+	}
+
+	//Free the dynamic array for the graph
+	for (int i1 = 0; i1 < vertices; i1++) {
+		free(matrix[i1]);
+	}
+	free(matrix);
+
+	printf("Done!\n");
+
+	MPI_Finalize();
+}
+
+/**
+ * Split a piece of work into tasks for the threads of this process and wait
+ * for them all to finish. Called by one thread while the others wait to run
+ * the tasks.
+ * @param workers The worker of each thread
+ * @param results The results of each thread
+ * @param start The first unit of the piece
+ * @param end One past the last unit of the piece
+ * @param grain The number of units in each task
+ */
+void searchPiece(struct SearchWorker** workers, struct Results* results, PermIndex start, PermIndex end,
+	PermIndex grain) {
+	for (PermIndex taskStart = start; taskStart < end; taskStart += grain) {
+		PermIndex taskEnd = taskStart + grain < end ? taskStart + grain : end;
+		#pragma omp task firstprivate(taskStart, taskEnd)
+		{
+			int id = omp_get_thread_num();
+			if (!searchStopped(&results[id])) {
+				searchWorkerRange(workers[id], taskStart, taskEnd);
+			}
+		}
+	}
+	#pragma omp taskwait
+}
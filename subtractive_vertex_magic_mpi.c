@@ -23,22 +23,46 @@
 #include <algorithm>
 #include <vector>
 
+#include "options.h"
+#include "perm_index.h"
+#include "perm_rank.h"
+#include "perm_range.h"
+#include "automorphism.h"
+#include "codegen.h"
+#include "family_kernels.h"
+#include "graph.h"
+#include "magic_range.h"
+#include "search_worker.h"
+#include "simd_eval.h"
+#include "results.h"
+#include "result_file.h"
+#include "result_stream.h"
+#include "work_scheduler.h"
+
 #define OUTPUT_FILE_LINE_SIZE 1000
+#define TIME_LINE_SIZE 48 //Width of the time line when it is filled in after the labelings
+#define PIECES_PER_WORKER 64 //Pieces of work for each worker before their rates are known
 #define DEVELOPMENT 1 //Print out the permutations and write to file
 #define PRODUCTION 2 //Only write the permutations to the file
 
-struct Graph readGraph(char* filename);
-struct Graph generateGraph(int cycleSize, int connectingVertices);
-long factorial(int n);
-int* generatePermutation(long idx, int permSize);
-void printArr(int arr[], int size, int newline);
+FILE* createOutputFile(struct Options* options, int vertices, int** matrix,
+	double timeTaken, int padTime, long* timeOffset);
+void writeTimeLine(FILE* outputFile, double timeTaken, int padTime);
+void writeLabelings(FILE* outputFile, const PermIndex* worksIdxs, const int* magicNumbers, long count,
+	int permSize, long firstNumber, int orbitSize);
+void writeToOutput(const PermIndex* worksIdxs, const int* magicNumbers, long count, void* data);
+
+//Struct for where the writer process writes the labelings streamed to it
+struct OutputSink {
+	FILE* file;
+	struct ResultWriter* binary; //Written to instead of the file with --format, or NULL
+	int permSize;
+	int orbitSize;
 
-//Struct for a graph, holding the number of vertices, edges, and the
-//adjacency matrix for the graph
-struct Graph {
-	int vertices;
-	int edges;
-	int** graph;
+	//How many labelings have been written, and the most to write, or 0 for
+	//no limit
+	long written;
+	long limit;
 };
 
 //Run mode. Development -> print out permutations and write to file
@@ -46,14 +70,15 @@ struct Graph {
 const int MODE = DEVELOPMENT;
 
 int main(int argc, char *argv[]) {
-	int cycleSize = 4;
-	int connectingVertices = 2;
-	if (argc == 3) {
-		cycleSize = atoi(argv[1]);
-		connectingVertices = atoi(argv[2]);
-	}
+	struct Options options = parseOptions(argc, argv);
+	int cycleSize = options.cycleSize;
+	int connectingVertices = options.connectingVertices;
 
-	printf("Cycle size = %d\nConnecting vertices = %d\n", cycleSize, connectingVertices);
+	if (options.graphFile != NULL) {
+		printf("Graph file = %s\n", options.graphFile);
+	} else {
+		printf("Cycle size = %d\nConnecting vertices = %d\n", cycleSize, connectingVertices);
+	}
 
 	int returnVal;
 	returnVal = MPI_Init(&argc, &argv);
@@ -72,12 +97,16 @@ int main(int argc, char *argv[]) {
 	int vertices;
 	int edges;
 	int permSize;
-	long numPermutations;
+	PermIndex numPermutations;
 
 	if (rank == 0) {
 		//Generate the graph
-		//struct Graph graph = readGraph("graph.txt");
-		struct Graph graph = generateGraph(cycleSize, connectingVertices);
+		struct Graph graph;
+		if (options.graphFile != NULL) {
+			graph = readGraph(options.graphFile);
+		} else {
+			graph = generateGraph(cycleSize, connectingVertices);
+		}
 		vertices = graph.vertices;
 		edges = graph.edges;
 		matrix = graph.graph;
@@ -92,31 +121,17 @@ int main(int argc, char *argv[]) {
 		}
 
 		permSize = vertices + edges;
-		numPermutations = factorial(permSize);
+		numPermutations = factorialIndex(permSize);
 	}
 
 	//Broadcast out the graph
 	MPI_Bcast(&vertices, 1, MPI_INT, 0, MPI_COMM_WORLD);
 	MPI_Bcast(&edges, 1, MPI_INT, 0, MPI_COMM_WORLD);
 	MPI_Bcast(&permSize, 1, MPI_INT, 0, MPI_COMM_WORLD);
-	MPI_Bcast(&numPermutations, 1, MPI_LONG, 0, MPI_COMM_WORLD);
-
-	printf("Permutations: %ld\n", numPermutations);
-
-	long chunkSize = numPermutations / numThreads;
-	long numDoOneMore = numPermutations - chunkSize * numThreads;
-	long start = rank * chunkSize;
-	long end = start + chunkSize;
+	MPI_Bcast(&numPermutations, 1, permIndexType(), 0, MPI_COMM_WORLD);
 
-	printf("Start: %ld, end: %ld\n", start, end);
-
-	if (rank < numDoOneMore) {
-		start += rank;
-		end += rank + 1;
-	} else {
-		start += numDoOneMore;
-		end += numDoOneMore;
-	}
+	char numLine[PERM_INDEX_DIGITS];
+	printf("Permutations: %s\n", formatPermIndex(numPermutations, numLine));
 
 	if (rank != 0) {
 		matrix = (int **) malloc(vertices * sizeof(int *));
@@ -129,168 +144,236 @@ int main(int argc, char *argv[]) {
 	for (int i1 = 0; i1 < vertices; i1++) {
 		MPI_Bcast(matrix[i1], vertices, MPI_INT, 0, MPI_COMM_WORLD);
 	}
-	
-	int* permutation = generatePermutation(start, permSize);
 
-	time_t startTime;
-	time_t finishTime;
+	//Work out which magic numbers a labeling could have, limited to the ones
+	//asked for with --magic
+	struct MagicRange magic = feasibleMagicRange(vertices, edges, matrix);
+	if (options.magicSet) {
+		struct MagicRange asked = {options.magicLow, options.magicHigh};
+		magic = intersectMagicRange(magic, asked);
+	}
+	if (rank == 0) {
+		if (magicRangeSize(magic) > 0) {
+			printf("Magic numbers: %d to %d\n", magic.low, magic.high);
+		} else {
+			printf("Magic numbers: none possible\n");
+		}
+	}
 
-	startTime = time(NULL);
+	//The units of work the engine splits its search into
+	PermIndex numUnits = searchUnits(&options, vertices, edges, magic);
+
+	//Find the automorphisms of the graph to only search for the smallest
+	//labeling of each orbit
+	struct Symmetry symmetry;
+	struct Symmetry* symmetryPtr = NULL;
+	if (options.symmetry) {
+		symmetry = computeSymmetry(vertices, edges, matrix);
+		symmetryPtr = &symmetry;
+		printf("Automorphisms: %d\n", symmetry.order);
+	}
 
-	//Init vector to hold permutation indexes that work
-	std::vector<long> worksIdxs;
-	std::vector<int> magicNumbers;
-
-	//Loop over the permutations and check the graphs
-	int magicNumber, firstVertex, works, curVertexValue, vertex, edge, vertexIn, vertexOut;
-	for (long permIdx = start; permIdx < end; permIdx++) {
-		magicNumber = 0;
-		firstVertex = 1;
-		works = 1;
-		for (vertex = 0; vertex < vertices; vertex++) {
-			//Calculate the value for this vertex
-			curVertexValue = permutation[vertex];
-
-			//Add the values for the edges in
-			for (vertexIn = 0; vertexIn < vertices; vertexIn++) {
-				edge = matrix[vertexIn][vertex];
-				if (edge) {
-					//Add in edge value
-					curVertexValue += permutation[vertices + edge - 1];
-				}
+	//Use a check compiled for this family of graphs, or one generated for
+	//this graph, in the brute force loop when there is one. The first
+	//process builds a generated check and the rest load it from the cache.
+	FamilyKernel kernel = NULL;
+	if (options.engine == ENGINE_BRUTE) {
+		if (options.codegen) {
+			if (rank == 0) {
+				kernel = compileGraphKernel(vertices, edges, matrix, options.reorderSlots);
 			}
-
-			//Subtract the values for the edges out
-			for (vertexOut = 0; vertexOut < vertices; vertexOut++) {
-				edge = matrix[vertex][vertexOut];
-				if (edge) {
-					//Subtract edge value
-					curVertexValue -= permutation[vertices + edge - 1];
-				}
+			MPI_Barrier(MPI_COMM_WORLD);
+			if (rank != 0) {
+				kernel = compileGraphKernel(vertices, edges, matrix, options.reorderSlots);
 			}
+		} else if (options.graphFile == NULL && !options.reorderSlots) {
+			kernel = findFamilyKernel(cycleSize, connectingVertices);
+		}
+	}
 
-			if (firstVertex) {
-				//If this is the first vertex, set the magic number
-				magicNumber = curVertexValue;
-				firstVertex = 0;
-			} else {
-				//Check if this vertex value is the same as the magic number
-				if (magicNumber != curVertexValue) {
-					works = 0;
-					break;
-				}
+	time_t startTime;
+	time_t finishTime;
+
+	startTime = time(NULL);
+
+	//The labelings this process finds, or only how many with each magic
+	//number. With --first or --limit the processes share the number found,
+	//and all of them stop once the limit is reached.
+	struct SearchLimit limit;
+	initSearchLimit(&limit, options.limit);
+	if (options.limit > 0) {
+		shareSearchLimit(&limit, MPI_COMM_WORLD);
+	}
+	struct Results results = createResults(permSize, options.countOnly, options.limit > 0 ? &limit : NULL);
+
+	//With --stream the last process writes out the labelings while the others
+	//search, instead of the root gathering them all at the end
+	int streaming = options.stream && !options.countOnly && numThreads > 1;
+	int writer = numThreads - 1;
+	int numWorkers = streaming ? numThreads - 2 : numThreads - 1;
+	if (streaming && numWorkers < 1) {
+		if (rank == 0) {
+			printf("Streaming needs at least 3 processes: the root, a worker, and the writer.\n");
+		}
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	int orbitSize = options.symmetry ? symmetry.order : 0;
+	FILE* streamFile = NULL;
+	struct ResultWriter* streamWriter = NULL;
+	long timeOffset = 0;
+
+	if (numThreads == 1) {
+		//With one process there is nobody to hand out work to
+		struct SearchWorker worker = createSearchWorker(&options, vertices, edges, matrix,
+			symmetryPtr, magic, kernel, &results);
+		if (options.engine == ENGINE_SIMD) {
+			printf("SIMD path: %s\n", simdPathName(worker.se.path));
+		}
+		searchWorkerRange(&worker, 0, numUnits);
+		freeSearchWorker(&worker);
+	} else if (rank == 0) {
+		//The root hands out pieces of work as the other processes ask
+		PermIndex firstPiece = searchGrain(&options, permSize, numUnits,
+			(long) numWorkers * PIECES_PER_WORKER);
+		scheduleWork(numUnits, firstPiece, numWorkers, MPI_COMM_WORLD);
+	} else if (streaming && rank == writer) {
+		//The writer starts the output file, then writes the labelings as they
+		//come in. The time taken is filled in at the end.
+		if (options.format != FORMAT_TEXT) {
+			char binaryName[OUTPUT_FILE_LINE_SIZE];
+			outputFilename(&options, "svm", binaryName, OUTPUT_FILE_LINE_SIZE);
+			streamWriter = new struct ResultWriter(createResultWriter(binaryName, options.format, cycleSize,
+				connectingVertices, graphFileName(&options), vertices, edges, matrix, orbitSize));
+		} else {
+			streamFile = createOutputFile(&options, vertices, matrix, 0, 1, &timeOffset);
+		}
+		struct OutputSink sink = {streamFile, streamWriter, permSize, orbitSize, 0, options.limit};
+		receiveResultStream(numWorkers, !resultsUnordered(&options), MPI_COMM_WORLD, writeToOutput, &sink);
+		printf("Labelings streamed: %ld\n", sink.written);
+	} else {
+		//Work on pieces until the root runs out, or enough labelings are found
+		struct SearchWorker worker = createSearchWorker(&options, vertices, edges, matrix,
+			symmetryPtr, magic, kernel, &results);
+		if (rank == 1 && options.engine == ENGINE_SIMD) {
+			printf("SIMD path: %s\n", simdPathName(worker.se.path));
+		}
+		struct WorkFeed feed = startWorkFeed(MPI_COMM_WORLD, 0);
+		struct ResultStream stream;
+		if (streaming) {
+			stream = startResultStream(MPI_COMM_WORLD, writer);
+		}
+		PermIndex start, end;
+		while (nextWork(&feed, searchStopped(&results), &start, &end)) {
+			searchWorkerRange(&worker, start, end);
+			if (streaming) {
+				streamResults(&stream, &results, start, end);
 			}
 		}
-
-		if (works) {
-			worksIdxs.push_back(permIdx);
-			magicNumbers.push_back(magicNumber);
+		if (streaming) {
+			finishResultStream(&stream);
 		}
-
-		std::next_permutation(permutation, permutation + permSize);
+		freeSearchWorker(&worker);
 	}
 
 	//Wait for all to finish before the end time is calculated
 	MPI_Barrier(MPI_COMM_WORLD);
+	if (options.limit > 0) {
+		freeSearchLimit(&limit);
+	}
 
 	finishTime = time(NULL);
 	double timeTaken = difftime(finishTime, startTime);
 
-	//Do a gather to get the sizes of each of the arrays
-	int size = worksIdxs.size();
-	int* sizes = NULL;
-	if (rank == 0) {
-		sizes = (int *) malloc(numThreads * sizeof(int));
+	if (streamFile != NULL) {
+		fseek(streamFile, timeOffset, SEEK_SET);
+		writeTimeLine(streamFile, timeTaken, 1);
+		fclose(streamFile);
+	}
+	if (streamWriter != NULL) {
+		finishResultWriter(streamWriter, timeTaken);
+		delete streamWriter;
 	}
 
-	//Gather the sizes to the root
-	MPI_Gather(&size, 1, MPI_INT, sizes, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	//Add up the counts of every process on the root
+	PermIndex* allCounts = NULL;
+	if (rank == 0) {
+		allCounts = (PermIndex *) malloc(results.histogram.size() * sizeof(PermIndex));
+	}
+	MPI_Reduce(&results.histogram[0], allCounts, results.histogram.size(), permIndexType(),
+		permIndexSum(), 0, MPI_COMM_WORLD);
 
-	//Init arrays for works idxs, magic numbers, and displacements
-	long* allWorksIdxs = NULL;
+	//Without streaming, gather the labelings of every process on the root to
+	//be written out
+	int numPermsWork = 0;
+	PermIndex* allWorksIdxs = NULL;
 	int* allMagicNumbers = NULL;
-	int* displs = NULL;
-
-	//Calculate total number of perms that work and displacement array
-	int numPermsWork;
-	if (rank == 0) {
-		numPermsWork = 0;
-		for (int i1 = 0; i1 < numThreads; i1++) {
-			numPermsWork += sizes[i1];
+	if (!streaming) {
+		//Do a gather to get the sizes of each of the arrays
+		std::vector<PermIndex>& worksIdxs = results.worksIdxs;
+		std::vector<int>& magicNumbers = results.magicNumbers;
+		int size = worksIdxs.size();
+		int* sizes = NULL;
+		if (rank == 0) {
+			sizes = (int *) malloc(numThreads * sizeof(int));
 		}
-		allWorksIdxs = (long *) malloc(numPermsWork * sizeof(long));
-		allMagicNumbers = (int *) malloc(numPermsWork * sizeof(int));
-		displs = (int *) malloc(numThreads * sizeof(int));
 
-		int displ = 0;
-		for (int i1 = 0; i1 < numThreads; i1++) {
-			displs[i1] = displ;
-			displ += sizes[i1];
-		}
-	}
+		//Gather the sizes to the root
+		MPI_Gather(&size, 1, MPI_INT, sizes, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
-	//Use gatherv to get the indices and magic numbers from each process
-	MPI_Gatherv(&worksIdxs[0], size, MPI_LONG, allWorksIdxs, sizes, displs, MPI_LONG, 0, MPI_COMM_WORLD);
-	MPI_Gatherv(&magicNumbers[0], size, MPI_INT, allMagicNumbers, sizes, displs, MPI_INT, 0, MPI_COMM_WORLD);
+		//Init array for displacements
+		int* displs = NULL;
 
-	if (rank == 0) {
-		//Output file to store permutations
-		//Write the graph parameters to the first line
-		char filename[OUTPUT_FILE_LINE_SIZE];
-		sprintf(filename, "output_%d_%d.txt", cycleSize, connectingVertices);
-		FILE* outputFile = fopen(filename, "w");
-		char firstLine[OUTPUT_FILE_LINE_SIZE];
-		sprintf(firstLine, "Graph: Cycle size = %d, connecting vertices = %d\n",
-			cycleSize, connectingVertices);
-		fputs(firstLine, outputFile);
-
-		//Write the time taken to the file
-		char timeLine[OUTPUT_FILE_LINE_SIZE];
-		sprintf(timeLine, "Time taken: %f seconds\n", timeTaken);
-		fputs(timeLine, outputFile);
-
-		//Write the adjacency matrix to the output file
-		char matrixLine[OUTPUT_FILE_LINE_SIZE] = "";
-		for (int i1 = 0; i1 < vertices; i1++) {
-			for (int i2 = 0; i2 < vertices; i2++) {
-				int edge = matrix[i1][i2];
-				char part[3];
-				sprintf(part, "%d ", edge);
-				strcat(matrixLine, part);
+		//Calculate total number of perms that work and displacement array
+		if (rank == 0) {
+			for (int i1 = 0; i1 < numThreads; i1++) {
+				numPermsWork += sizes[i1];
 			}
-			//Add \n to the end
-			char end[2] = "\n";
-			strcat(matrixLine, end);
-		}
-		//Write line to file
-		fputs(matrixLine, outputFile);
-
-		for (int i1 = 0; i1 < numPermsWork; i1++) {
-			long permIdx = allWorksIdxs[i1];
-			int magicNumber = allMagicNumbers[i1];
-			int* perm = generatePermutation(permIdx, permSize);
-			printArr(perm, permSize, 0);
-			printf(" Magic number: %d\n", magicNumber);
-
-			//Write the permutation to the output file
-			char outputLine[OUTPUT_FILE_LINE_SIZE] = "";
-			sprintf(outputLine, "%d: {", (i1 + 1));
-			for (int i1 = 0; i1 < permSize; i1++) {
-				char part[10]; //Shouldn't ever be bigger than 6, 10 to be save
-				if (i1 != permSize - 1) {
-					sprintf(part, "%d, ", perm[i1]);
-				} else {
-					sprintf(part, "%d", perm[i1]);
-				}
-				strcat(outputLine, part);
+			allWorksIdxs = (PermIndex *) malloc(numPermsWork * sizeof(PermIndex));
+			allMagicNumbers = (int *) malloc(numPermsWork * sizeof(int));
+			displs = (int *) malloc(numThreads * sizeof(int));
+
+			int displ = 0;
+			for (int i1 = 0; i1 < numThreads; i1++) {
+				displs[i1] = displ;
+				displ += sizes[i1];
 			}
-			char end[25]; //Shouldn't be bigger than 21, 25 to be save
-			sprintf(end, "} Magic Number: %d\n", magicNumber);
-			strcat(outputLine, end);
-			fputs(outputLine, outputFile);
+		}
+
+		//Use gatherv to get the indices and magic numbers from each process
+		MPI_Gatherv(&worksIdxs[0], size, permIndexType(), allWorksIdxs, sizes, displs, permIndexType(), 0, MPI_COMM_WORLD);
+		MPI_Gatherv(&magicNumbers[0], size, MPI_INT, allMagicNumbers, sizes, displs, MPI_INT, 0, MPI_COMM_WORLD);
+
+		if (rank == 0) {
+			//Pieces of work are handed out in any order, and some engines do not
+			//find labelings in index order either
+			sortResults(allWorksIdxs, allMagicNumbers, numPermsWork);
+		}
 
-			free(perm);
+		//Processes can each find some before they hear the limit was reached,
+		//so only keep the first ones
+		if (rank == 0 && options.limit > 0 && numPermsWork > options.limit) {
+			numPermsWork = options.limit;
 		}
+	}
+
+	//Write the labelings to a binary file instead of the text one when asked
+	if (rank == 0 && !streaming && options.format != FORMAT_TEXT && !options.countOnly) {
+		char binaryName[OUTPUT_FILE_LINE_SIZE];
+		outputFilename(&options, "svm", binaryName, OUTPUT_FILE_LINE_SIZE);
+		struct ResultWriter writer = createResultWriter(binaryName, options.format, cycleSize, connectingVertices,
+			graphFileName(&options), vertices, edges, matrix, orbitSize);
+		writeResultLabelings(&writer, allWorksIdxs, allMagicNumbers, numPermsWork);
+		finishResultWriter(&writer, timeTaken);
+	} else if (rank == 0 && !streaming) {
+		FILE* outputFile = createOutputFile(&options, vertices, matrix, timeTaken, 0, NULL);
+
+		if (options.countOnly) {
+			int countOrbitSize = options.symmetry ? symmetry.order : 1;
+			writeCounts(stdout, allCounts, results.histogram.size(), results.magicOffset, countOrbitSize);
+			writeCounts(outputFile, allCounts, results.histogram.size(), results.magicOffset, countOrbitSize);
+		}
+
+		writeLabelings(outputFile, allWorksIdxs, allMagicNumbers, numPermsWork, permSize, 1, orbitSize);
 
 		//Close the file
 		if (outputFile != NULL) {
@@ -314,7 +397,6 @@ int main(int argc, char *argv[]) {
 		free(matrix[i1]);
 	}
 	free(matrix);
-	free(permutation);
 
 	printf("Done!\n");
 
@@ -322,197 +404,129 @@ int main(int argc, char *argv[]) {
 }
 
 /**
- * Read in a graph from a given text file.
- * The first line should contain the number of vertices in the graph.
- * Then the file should contain the adjacency matrix of the graph.
- * @param filename The name of the file containing the graph data
- * @return A struct of the number of vertices, edges, and the adjacency matrix
+ * Create the output file and write the graph parameters, the time taken and
+ * the adjacency matrix to it
+ * @param options The parsed options, which name the file and describe the graph
+ * @param vertices The number of vertices in the graph
+ * @param matrix The adjacency matrix of the graph
+ * @param timeTaken The time the search took
+ * @param padTime 1 to pad the time line so it can be written again later
+ * @param timeOffset Set to where the time line starts, or NULL
+ * @return The output file, with the labelings to be written next
  */
-struct Graph readGraph(char* filename) {
-	FILE *file;
-	file = fopen(filename, "r");
-
-	int vertices;
-	int edges = 0;
-
-	//First line of input file is number of vertices
-	int result = fscanf(file, "%d\n", &vertices);
-	if (result != 1) {
-		printf("An error occured getting graph size from input file.\n");
-		exit(1);
+FILE* createOutputFile(struct Options* options, int vertices, int** matrix,
+	double timeTaken, int padTime, long* timeOffset) {
+	//Output file to store permutations
+	//Write the graph parameters to the first line
+	char filename[OUTPUT_FILE_LINE_SIZE];
+	outputFilename(options, "txt", filename, OUTPUT_FILE_LINE_SIZE);
+	FILE* outputFile = fopen(filename, "w");
+	char firstLine[OUTPUT_FILE_LINE_SIZE];
+	outputGraphLine(options, firstLine, OUTPUT_FILE_LINE_SIZE);
+	fputs(firstLine, outputFile);
+
+	//Write the time taken to the file
+	if (timeOffset != NULL) {
+		*timeOffset = ftell(outputFile);
 	}
+	writeTimeLine(outputFile, timeTaken, padTime);
 
-	//Init adjacency matrix
-	int** graph = (int **) malloc(vertices * sizeof(int *));
-
-	char* res;
-
-	//Loop over each vertex
+	//Write the adjacency matrix to the output file
+	char matrixLine[OUTPUT_FILE_LINE_SIZE] = "";
 	for (int i1 = 0; i1 < vertices; i1++) {
-		graph[i1] = (int *) malloc(vertices * sizeof(int));
-		size_t len;
-
-		//Read in the line
-		char line[256]; //Hope this is big enough
-		res = fgets(line, sizeof(line), file);
-		if (res == NULL) {
-			printf("An error occured reading line from input file.\n");
-			exit(1);
-		}
-
-		//Split the line into each number
-		char* part = strtok(line, " ");
-		int c = 0;
-		while (part) {
-			char numC = part[0];
-			int num = numC - '0';
-			if (num == 0) {
-				graph[i1][c] = 0;
-			} else {
-				edges += num;
-				graph[i1][c] = edges;
-			}
-			part = strtok(NULL, " ");
-			c++;
+		for (int i2 = 0; i2 < vertices; i2++) {
+			int edge = matrix[i1][i2];
+			char part[3];
+			sprintf(part, "%d ", edge);
+			strcat(matrixLine, part);
 		}
+		//Add \n to the end
+		char end[2] = "\n";
+		strcat(matrixLine, end);
 	}
+	//Write line to file
+	fputs(matrixLine, outputFile);
 
-	fclose(file);
-
-	struct Graph g;
-	g.vertices = vertices;
-	g.edges = edges;
-	g.graph = graph;
-
-	return g;
+	return outputFile;
 }
 
 /**
- * Generates a graph of two cycles connected by some vertices
- * @param cycleSize The size of the cycles to be connected
- * @param connectingVertices The number of vertices the cycles are connected by
- * @return A struct of the number of vertices, edges, and the adjacency matrix
+ * Write the time taken line of the output file. When streaming, the line is
+ * written before the search and again after it, so it is padded to the same
+ * width both times.
+ * @param outputFile The output file
+ * @param timeTaken The time the search took
+ * @param padTime 1 to pad the line to TIME_LINE_SIZE
  */
-struct Graph generateGraph(int cycleSize, int connectingVertices) {
-	//Calculate number of vertices and generate adjacency matrix
-	int vertices = 2 * cycleSize - connectingVertices;
-	int** graph = (int **) malloc(vertices * sizeof(int *));
-	for (int i1 = 0; i1 < vertices; i1++) {
-		graph[i1] = (int *) malloc(vertices * sizeof(int));
-		for (int i2 = 0; i2 < vertices; i2++) {
-			graph[i1][i2] = 0;
-		}
-	}
-
-	//Connect the vertices
-	graph[0][cycleSize - 1] = 1;
-	graph[cycleSize - connectingVertices][vertices - 1] = cycleSize - connectingVertices + 2;
-	int edges = 2;
-	for (int i1 = 1; i1 < vertices; i1++) {
-		if (i1 < cycleSize - connectingVertices + 1) {
-			graph[i1][i1 - 1] = i1 + 1;
-		} else {
-			graph[i1][i1 - 1] = i1 + 2;
-		}
-		edges++;
-	}
-
-	struct Graph g;
-	g.vertices = vertices;
-	g.edges = edges;
-	g.graph = graph;
-
-	return g;
+void writeTimeLine(FILE* outputFile, double timeTaken, int padTime) {
+	char timeLine[OUTPUT_FILE_LINE_SIZE];
+	sprintf(timeLine, "Time taken: %f seconds", timeTaken);
+	fprintf(outputFile, "%-*s\n", padTime ? TIME_LINE_SIZE : 0, timeLine);
 }
 
 /**
- * Recursively calculate the factorial of the given number
- * @param n The number to calculate the factorial of
- * @return n!
+ * Print out labelings and write them to the output file, numbered from a
+ * given number
+ * @param outputFile The output file
+ * @param worksIdxs The permutation indexes of the labelings
+ * @param magicNumbers The magic number of each labeling
+ * @param count How many labelings
+ * @param permSize The number of labels
+ * @param firstNumber The number of the first labeling in the file
+ * @param orbitSize The size of each orbit when only the smallest labeling of
+ *                  each is found, or 0 to leave it out
  */
-long factorial(int n) {
-	if (n == 0) {
-		return 1;
-	}
-	if (n == 1 || n == 2) {
-		return n;
-	}
-
-	return n * factorial(n - 1);
-}
-
-int* generatePermutation(long idx, int permSize) {
-	int* permutation = (int *) malloc(permSize * sizeof(int));
-	for (int i1 = 0; i1 < permSize; i1++) {
-		permutation[i1] = i1 + 1;
-	}
-	if (idx != 0) {
-		//Generate perm for idx using factoradic numbers
-		int factoradicLength = 0;
-		long factorials[permSize];
-		long fac = 1;
-		int count = 0;
-		while (idx >= fac) {
-			fac = factorial(factoradicLength);
-			factorials[count] = fac;
-			count++;
-			factoradicLength++;
-		}
-		factoradicLength--;
-		//printf("Factoradic length: %d\n", factoradicLength);
-
-		long factoradic[permSize];
-		for (int i1 = 0; i1 < permSize; i1++) {
-			factoradic[i1] = 0;
-		}
-
-		//printf("Array inited\n");
-
-		long cur = idx;
-		count = 0;
-		for (int i1 = factoradicLength - 1; i1 >= 0; i1--) {
-			long fNum = cur / factorials[i1];
-			//printf("fNum = %ld\n", fNum);
-			factoradic[count + permSize - factoradicLength] = fNum;
-			count++;
-			cur = cur % factorials[i1];
-		}
-
-		int permutationTemp[permSize];
-		permutationTemp[0] = factoradic[0] + 1;
-		permutation[factoradic[0]] = -1;
-		for (int i1 = 1; i1 < permSize; i1++) {
-			int fNum = factoradic[i1];
-			int permIdx = 0;
-			int actualIdx = 0;
-			while (permIdx != fNum || permutation[actualIdx] == -1) {
-				if (permutation[actualIdx] != -1) {
-					permIdx++;
-				}
-				actualIdx++;
+void writeLabelings(FILE* outputFile, const PermIndex* worksIdxs, const int* magicNumbers, long count,
+	int permSize, long firstNumber, int orbitSize) {
+	int* perms = (int *) malloc(count * permSize * sizeof(int));
+	unrankBatch(worksIdxs, count, permSize, perms);
+	for (long i1 = 0; i1 < count; i1++) {
+		int magicNumber = magicNumbers[i1];
+		int* perm = perms + i1 * permSize;
+		printArr(perm, permSize, 0);
+		printf(" Magic number: %d\n", magicNumber);
+
+		//Write the permutation to the output file
+		char outputLine[OUTPUT_FILE_LINE_SIZE] = "";
+		sprintf(outputLine, "%ld: {", firstNumber + i1);
+		for (int i2 = 0; i2 < permSize; i2++) {
+			char part[10]; //Shouldn't ever be bigger than 6, 10 to be save
+			if (i2 != permSize - 1) {
+				sprintf(part, "%d, ", perm[i2]);
+			} else {
+				sprintf(part, "%d", perm[i2]);
 			}
-			permutationTemp[i1] = permutation[actualIdx];
-			permutation[actualIdx] = -1;
+			strcat(outputLine, part);
 		}
-
-		for (int i1 = 0; i1 < permSize; i1++) {
-			permutation[i1] = permutationTemp[i1];
+		char end[50]; //Shouldn't be bigger than 40, 50 to be safe
+		if (orbitSize > 0) {
+			sprintf(end, "} Magic Number: %d Orbit size: %d\n", magicNumber, orbitSize);
+		} else {
+			sprintf(end, "} Magic Number: %d\n", magicNumber);
 		}
+		strcat(outputLine, end);
+		fputs(outputLine, outputFile);
 	}
-
-	return permutation;
+	free(perms);
 }
 
-void printArr(int arr[], int size, int newline) {
-	printf("{");
-	for (int i1 = 0; i1 < size; i1++) {
-		printf("%d", arr[i1]);
-		if (i1 != size - 1) {
-			printf(", ");
-		}
+/**
+ * Write out labelings streamed to the writer, up to the limit
+ * @param worksIdxs The permutation indexes of the labelings, in order
+ * @param magicNumbers The magic number of each labeling
+ * @param count How many labelings
+ * @param data The OutputSink to write to
+ */
+void writeToOutput(const PermIndex* worksIdxs, const int* magicNumbers, long count, void* data) {
+	struct OutputSink* sink = (struct OutputSink *) data;
+	if (sink->limit > 0 && sink->written + count > sink->limit) {
+		count = sink->limit - sink->written;
 	}
-	printf("}");
-	if (newline) {
-		printf("\n");
+	if (sink->binary != NULL) {
+		writeResultLabelings(sink->binary, worksIdxs, magicNumbers, count);
+	} else {
+		writeLabelings(sink->file, worksIdxs, magicNumbers, count, sink->permSize, sink->written + 1,
+			sink->orbitSize);
 	}
+	sink->written += count;
 }
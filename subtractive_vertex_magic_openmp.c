@@ -22,39 +22,51 @@
 #include <math.h>
 #include <time.h>
 
+#include <atomic>
 #include <vector>
 #include <algorithm>
 
+#include "options.h"
+#include "perm_index.h"
+#include "perm_rank.h"
+#include "perm_range.h"
+#include "automorphism.h"
+#include "codegen.h"
+#include "family_kernels.h"
+#include "graph.h"
+#include "magic_range.h"
+#include "search_worker.h"
+#include "simd_eval.h"
+#include "results.h"
+#include "result_file.h"
+#include "text_output.h"
+
 #define OUTPUT_FILE_LINE_SIZE 1000
+#define TASKS_PER_THREAD 64 //Pieces of work for each thread to balance the load
+#define TASK_SPLITS 3 //Most times a task still running at the end is split into smaller ones
 #define DEVELOPMENT 1 //Print out the permutations and write to file
 #define PRODUCTION 2 //Only write the permutations to the file
 
-struct Graph readGraph(char* filename);
-struct Graph generateGraph(int cycleSize, int connectingVertices);
-long factorial(int n);
-int* generatePermutation(long idx, int permSize);
-void printArr(int arr[], int size, int newline);
-
-//Struct for a graph, holding the number of vertices, edges, and the
-//adjacency matrix for the graph
-struct Graph {
-	int vertices;
-	int edges;
-	int** graph;
-};
+void spawnSearchTask(struct Options* options, int permSize, struct SearchWorker** workers, struct Results* results,
+	PermIndex start, PermIndex end, PermIndex grain, int splits, std::atomic<long>* waiting);
 
 int main(int argc, char *argv[]) {
-	int cycleSize = 4;
-	int connectingVertices = 2;
-	if (argc == 3) {
-		cycleSize = atoi(argv[1]);
-		connectingVertices = atoi(argv[2]);
+	struct Options options = parseOptions(argc, argv);
+	int cycleSize = options.cycleSize;
+	int connectingVertices = options.connectingVertices;
+
+	if (options.graphFile != NULL) {
+		printf("Graph file = %s\n", options.graphFile);
+	} else {
+		printf("Cycle size = %d\nConnecting vertices = %d\n", cycleSize, connectingVertices);
 	}
 
-	printf("Cycle size = %d\nConnecting vertices = %d\n", cycleSize, connectingVertices);
-
-	//struct Graph graph = readGraph("graph.txt");
-	struct Graph graph = generateGraph(cycleSize, connectingVertices);
+	struct Graph graph;
+	if (options.graphFile != NULL) {
+		graph = readGraph(options.graphFile);
+	} else {
+		graph = generateGraph(cycleSize, connectingVertices);
+	}
 	int vertices = graph.vertices;
 	int edges = graph.edges;
 	int** matrix = graph.graph;
@@ -69,18 +81,72 @@ int main(int argc, char *argv[]) {
 	}
 
 	int permSize = vertices + edges;
-	long numPermutations = factorial(permSize);
-	int numThreads = omp_get_num_procs();
-	long chunkSize = numPermutations / numThreads;
-	long numDoOneMore = numPermutations - chunkSize * numThreads;
+	PermIndex numPermutations = factorialIndex(permSize);
+	int numThreads = omp_get_max_threads();
+
+	//Work out which magic numbers a labeling could have, limited to the ones
+	//asked for with --magic
+	struct MagicRange magic = feasibleMagicRange(vertices, edges, matrix);
+	if (options.magicSet) {
+		struct MagicRange asked = {options.magicLow, options.magicHigh};
+		magic = intersectMagicRange(magic, asked);
+	}
+	if (magicRangeSize(magic) > 0) {
+		printf("Magic numbers: %d to %d\n", magic.low, magic.high);
+	} else {
+		printf("Magic numbers: none possible\n");
+	}
 
-	printf("Num permutations = %ld\n", numPermutations);
+	//The work is split into many more tasks than threads, so threads that
+	//finish early take tasks that would have waited for a slower one. For
+	//the engines that split by permutation index each task is a label prefix,
+	//and a task still running once the others are taken is split into longer
+	//prefixes.
+	PermIndex numUnits = searchUnits(&options, vertices, edges, magic);
+	PermIndex grain = searchGrain(&options, permSize, numUnits, (long) numThreads * TASKS_PER_THREAD);
+	long numTasks = (numUnits + grain - 1) / grain;
+
+	char numLine[PERM_INDEX_DIGITS];
+	printf("Num permutations = %s\n", formatPermIndex(numPermutations, numLine));
 	printf("Threads: %d\n", numThreads);
-	printf("Chunk size: %ld\n", chunkSize);
+	printf("Tasks: %ld of %s units\n", numTasks, formatPermIndex(grain, numLine));
+
+	//Find the automorphisms of the graph to only search for the smallest
+	//labeling of each orbit
+	struct Symmetry symmetry;
+	struct Symmetry* symmetryPtr = NULL;
+	if (options.symmetry) {
+		symmetry = computeSymmetry(vertices, edges, matrix);
+		symmetryPtr = &symmetry;
+		printf("Automorphisms: %d\n", symmetry.order);
+	}
+
+	//Use a check compiled for this family of graphs, or one generated for
+	//this graph, in the brute force loop when there is one
+	FamilyKernel kernel = NULL;
+	if (options.engine == ENGINE_BRUTE) {
+		if (options.codegen) {
+			kernel = compileGraphKernel(vertices, edges, matrix, options.reorderSlots);
+		} else if (options.graphFile == NULL && !options.reorderSlots) {
+			kernel = findFamilyKernel(cycleSize, connectingVertices);
+		}
+	}
+
+	//The labelings found by each thread, or only how many with each magic
+	//number. With --first or --limit the threads share one limit, and all of
+	//them stop once it is reached.
+	struct SearchLimit limit;
+	initSearchLimit(&limit, options.limit);
+	std::vector<struct Results> results(numThreads,
+		createResults(permSize, options.countOnly, options.limit > 0 ? &limit : NULL));
+	std::vector<struct SearchWorker*> workers(numThreads);
+
+	//How many tasks are waiting for a thread to take them
+	std::atomic<long> waiting(0);
 
-	//Vectors to store permutation index and the magic number for each thread
-	std::vector<long> worksIdxs[numThreads];
-	std::vector<int> magicNumbers[numThreads];
+	//Each thread's engine gets an equal share of the memory for the meet in
+	//the middle records
+	options.memoryLimit /= numThreads;
 
 	//Time how long it takes from start to finish
 	time_t start;
@@ -90,152 +156,101 @@ int main(int argc, char *argv[]) {
 
 	#pragma omp parallel num_threads(numThreads)
 	{
-		//Get the ID and calculate the start and end indexes
+		//Each thread sets up its own engine, which runs whichever tasks the
+		//thread picks up
 		int id = omp_get_thread_num();
-		printf("ID = %d\n", id);
-		long start = id * chunkSize;
-		long end = start + chunkSize;
-
-		printf("Start: %ld, End: %ld\n", start, end);
-
-		if (id < numDoOneMore) {
-			start += id;
-			end += id + 1;
-		} else {
-			start += numDoOneMore;
-			end += numDoOneMore;
+		struct SearchWorker worker = createSearchWorker(&options, vertices, edges, matrix,
+			symmetryPtr, magic, kernel, &results[id]);
+		if (id == 0 && options.engine == ENGINE_SIMD) {
+			printf("SIMD path: %s\n", simdPathName(worker.se.path));
 		}
-
-		//start = 2335132800;
-		//end = 3113510400;
-		
-		//Generate the first permutation
-		int* permutation = generatePermutation(start, permSize);
-
-		//Loop over the permutations and check the graphs
-		int permIdx, magicNumber, firstVertex, works, curVertexValue, vertex, edge, vertexIn, vertexOut;
-		for (long permIdx = start; permIdx < end; permIdx++) {
-			magicNumber = 0;
-			firstVertex = 1;
-			works = 1;
-			for (vertex = 0; vertex < vertices; vertex++) {
-				//Calculate the value for this vertex
-				curVertexValue = permutation[vertex];
-
-				//Add the values for the edges in
-				for (vertexIn = 0; vertexIn < vertices; vertexIn++) {
-					edge = matrix[vertexIn][vertex];
-					if (edge) {
-						//Add in edge value
-						curVertexValue += permutation[vertices + edge - 1];
-					}
-				}
-
-				//Subtract the values for the edges out
-				for (vertexOut = 0; vertexOut < vertices; vertexOut++) {
-					edge = matrix[vertex][vertexOut];
-					if (edge) {
-						//Subtract edge value
-						curVertexValue -= permutation[vertices + edge - 1];
-					}
-				}
-
-				if (firstVertex) {
-					//If this is the first vertex, set the magic number
-					magicNumber = curVertexValue;
-					firstVertex = 0;
-				} else {
-					//Check if this vertex value is the same as the magic number
-					if (magicNumber != curVertexValue) {
-						works = 0;
-						break;
-					}
-				}
+		workers[id] = &worker;
+		#pragma omp barrier
+
+		//One thread makes the tasks and every thread runs them, taking tasks
+		//from the others when it runs out
+		#pragma omp single
+		{
+			for (PermIndex taskStart = 0; taskStart < numUnits; taskStart += grain) {
+				PermIndex taskEnd = taskStart + grain < numUnits ? taskStart + grain : numUnits;
+				spawnSearchTask(&options, permSize, workers.data(), results.data(), taskStart, taskEnd,
+					grain, TASK_SPLITS, &waiting);
 			}
-
-			if (works) {
-				worksIdxs[id].push_back(permIdx);
-				magicNumbers[id].push_back(magicNumber);
-			}
-
-			std::next_permutation(permutation, permutation + permSize);
 		}
 
-		free(permutation);
+		//Tasks run in any order on any thread, so each thread sorts its own
+		//labelings
+		sortResults(results[id].worksIdxs, results[id].magicNumbers);
+		freeSearchWorker(&worker);
 	}
 
 	finish = time(NULL);
 
-	//Output file to store permutations
-	//Write the graph parameters to the first line
-	char filename[OUTPUT_FILE_LINE_SIZE];
-	sprintf(filename, "output_%d_%d.txt", cycleSize, connectingVertices);
-	FILE* outputFile = fopen(filename, "w");
-	char firstLine[OUTPUT_FILE_LINE_SIZE];
-	sprintf(firstLine, "Graph: Cycle size = %d, connecting vertices = %d\n",
-		cycleSize, connectingVertices);
-	fputs(firstLine, outputFile);
+	//Merge the sorted labelings of all the threads, and add up the counts
+	for (int thread = 0; thread < numThreads; thread++) {
+		printf("Thread %d has %lu\n", thread, results[thread].worksIdxs.size());
+	}
+	mergeSortedResults(&results[0], numThreads);
 
 	double timeTaken = difftime(finish, start);
-	char timeLine[OUTPUT_FILE_LINE_SIZE];
-	sprintf(timeLine, "Time taken: %f seconds\n", timeTaken);
-	fputs(timeLine, outputFile);
 
-	//Write the adjacency matrix to the output file
-	char matrixLine[OUTPUT_FILE_LINE_SIZE] = "";
-	for (int i1 = 0; i1 < vertices; i1++) {
-		for (int i2 = 0; i2 < vertices; i2++) {
-			int edge = matrix[i1][i2];
-			char part[3];
-			sprintf(part, "%d ", edge);
-			strcat(matrixLine, part);
+	//Write the labelings to a binary file instead of the text one when asked
+	if (options.format != FORMAT_TEXT && !options.countOnly) {
+		char binaryName[OUTPUT_FILE_LINE_SIZE];
+		outputFilename(&options, "svm", binaryName, OUTPUT_FILE_LINE_SIZE);
+		struct ResultWriter writer = createResultWriter(binaryName, options.format, cycleSize, connectingVertices,
+			graphFileName(&options), vertices, edges, matrix, options.symmetry ? symmetry.order : 0);
+		writeResultLabelings(&writer, results[0].worksIdxs.data(), results[0].magicNumbers.data(),
+			results[0].worksIdxs.size());
+		finishResultWriter(&writer, timeTaken);
+		printf("Num worked: %lu\n", results[0].worksIdxs.size());
+	} else {
+		//Output file to store permutations
+		//Write the graph parameters to the first line
+		char filename[OUTPUT_FILE_LINE_SIZE];
+		outputFilename(&options, "txt", filename, OUTPUT_FILE_LINE_SIZE);
+		FILE* outputFile = fopen(filename, "w");
+		char firstLine[OUTPUT_FILE_LINE_SIZE];
+		outputGraphLine(&options, firstLine, OUTPUT_FILE_LINE_SIZE);
+		fputs(firstLine, outputFile);
+
+		char timeLine[OUTPUT_FILE_LINE_SIZE];
+		sprintf(timeLine, "Time taken: %f seconds\n", timeTaken);
+		fputs(timeLine, outputFile);
+
+		//Write the adjacency matrix to the output file
+		char matrixLine[OUTPUT_FILE_LINE_SIZE] = "";
+		for (int i1 = 0; i1 < vertices; i1++) {
+			for (int i2 = 0; i2 < vertices; i2++) {
+				int edge = matrix[i1][i2];
+				char part[3];
+				sprintf(part, "%d ", edge);
+				strcat(matrixLine, part);
+			}
+			//Add \n to the end
+			char end[2] = "\n";
+			strcat(matrixLine, end);
+		}
+		//Write line to file
+		fputs(matrixLine, outputFile);
+
+		//When counting, every thread's counts are in the first one's results
+		if (options.countOnly) {
+			int orbitSize = options.symmetry ? symmetry.order : 1;
+			writeCounts(stdout, &results[0].histogram[0], results[0].histogram.size(), results[0].magicOffset, orbitSize);
+			writeCounts(outputFile, &results[0].histogram[0], results[0].histogram.size(), results[0].magicOffset, orbitSize);
 		}
-		//Add \n to the end
-		char end[2] = "\n";
-		strcat(matrixLine, end);
-	}
-	//Write line to file
-	fputs(matrixLine, outputFile);
 
-	//Print out the results
-	int c = 0;
-	for (int thread = 0; thread < numThreads; thread++) {
-		int size = worksIdxs[thread].size();
-		printf("Thread %d has %d\n", thread, size);
-		for (int i2 = 0; i2 < size; i2++) {
-			long permIdx = worksIdxs[thread][i2];
-			int magicNumber = magicNumbers[thread][i2];
-			int* permutation = generatePermutation(permIdx, permSize);
-			
-			//printArr(permutation, permSize, 0);
-			//printf(" Magic Number: %d\n", magicNumber);
-
-			//Write the permutation to the output file
-			char outputLine[OUTPUT_FILE_LINE_SIZE] = "";
-			sprintf(outputLine, "%d: {", (++c));
-			for (int i1 = 0; i1 < permSize; i1++) {
-				char part[10]; //Shouldn't ever be bigger than 6, 10 to be save
-				if (i1 != permSize - 1) {
-					sprintf(part, "%d, ", permutation[i1]);
-				} else {
-					sprintf(part, "%d", permutation[i1]);
-				}
-				strcat(outputLine, part);
-			}
-			char end[25]; //Shouldn't be bigger than 21, 25 to be save
-			sprintf(end, "} Magic Number: %d\n", magicNumber);
-			strcat(outputLine, end);
-			fputs(outputLine, outputFile);
+		//Format the labelings on every thread while another writes them out
+		writeTextLabelings(outputFile, results[0].worksIdxs.data(), results[0].magicNumbers.data(),
+			results[0].worksIdxs.size(), permSize, options.symmetry ? symmetry.order : 0, numThreads);
 
-			free(permutation);
+		//Close the file
+		if (outputFile != NULL) {
+			fclose(outputFile);
 		}
 	}
 
-	//Close the file
-	if (outputFile != NULL) {
-		fclose(outputFile);
-	}
-
 	//Free the dynamic array for the graph
 	for (int i1 = 0; i1 < vertices; i1++) {
 		free(matrix[i1]);
@@ -246,197 +261,42 @@ int main(int argc, char *argv[]) {
 }
 
 /**
- * Read in a graph from a given text file.
- * The first line should contain the number of vertices in the graph.
- * Then the file should contain the adjacency matrix of the graph.
- * @param filename The name of the file containing the graph data
- * @return A struct of the number of vertices, edges, and the adjacency matrix
+ * Make a task to search a piece of work. The task searches the piece in
+ * smaller pieces one at a time, and if there are fewer tasks waiting than
+ * threads before one of them, it makes tasks of the rest instead, so a heavy
+ * prefix is shared out rather than holding up the end of the search.
+ * @param options The parsed options
+ * @param permSize The number of labels
+ * @param workers The worker of each thread
+ * @param results The results of each thread
+ * @param start The first unit of the piece
+ * @param end One past the last unit of the piece
+ * @param grain The number of units in the piece, a whole prefix for the
+ *              engines that split by permutation index
+ * @param splits How many more times the piece can be split
+ * @param waiting The number of tasks no thread has taken yet
  */
-struct Graph readGraph(char* filename) {
-	FILE *file;
-	file = fopen(filename, "r");
-
-	int vertices;
-	int edges = 0;
-
-	//First line of input file is number of vertices
-	int result = fscanf(file, "%d\n", &vertices);
-	if (result != 1) {
-		printf("An error occured getting graph size from input file.\n");
-		exit(1);
-	}
-
-	//Init adjacency matrix
-	int** graph = (int **) malloc(vertices * sizeof(int *));
-
-	char* res;
-
-	//Loop over each vertex
-	for (int i1 = 0; i1 < vertices; i1++) {
-		graph[i1] = (int *) malloc(vertices * sizeof(int));
-		size_t len;
-
-		//Read in the line
-		char line[256]; //Hope this is big enough
-		res = fgets(line, sizeof(line), file);
-		if (res == NULL) {
-			printf("An error occured reading line from input file.\n");
-			exit(1);
-		}
-
-		//Split the line into each number
-		char* part = strtok(line, " ");
-		int c = 0;
-		while (part) {
-			char numC = part[0];
-			int num = numC - '0';
-			if (num == 0) {
-				graph[i1][c] = 0;
-			} else {
-				edges += num;
-				graph[i1][c] = edges;
-			}
-			part = strtok(NULL, " ");
-			c++;
-		}
-	}
-
-	fclose(file);
-
-	struct Graph g;
-	g.vertices = vertices;
-	g.edges = edges;
-	g.graph = graph;
-
-	return g;
-}
-
-/**
- * Generates a graph of two cycles connected by some vertices
- * @param cycleSize The size of the cycles to be connected
- * @param connectingVertices The number of vertices the cycles are connected by
- * @return A struct of the number of vertices, edges, and the adjacency matrix
- */
-struct Graph generateGraph(int cycleSize, int connectingVertices) {
-	//Calculate number of vertices and generate adjacency matrix
-	int vertices = 2 * cycleSize - connectingVertices;
-	int** graph = (int **) malloc(vertices * sizeof(int *));
-	for (int i1 = 0; i1 < vertices; i1++) {
-		graph[i1] = (int *) malloc(vertices * sizeof(int));
-		for (int i2 = 0; i2 < vertices; i2++) {
-			graph[i1][i2] = 0;
-		}
-	}
-
-	//Connect the vertices
-	graph[0][cycleSize - 1] = 1;
-	graph[cycleSize - connectingVertices][vertices - 1] = cycleSize - connectingVertices + 2;
-	int edges = 2;
-	for (int i1 = 1; i1 < vertices; i1++) {
-		if (i1 < cycleSize - connectingVertices + 1) {
-			graph[i1][i1 - 1] = i1 + 1;
-		} else {
-			graph[i1][i1 - 1] = i1 + 2;
-		}
-		edges++;
-	}
-
-	struct Graph g;
-	g.vertices = vertices;
-	g.edges = edges;
-	g.graph = graph;
-
-	return g;
-}
-
-/**
- * Recursively calculate the factorial of the given number
- * @param n The number to calculate the factorial of
- * @return n!
- */
-long factorial(int n) {
-	if (n == 0) {
-		return 1;
-	}
-	if (n == 1 || n == 2) {
-		return n;
-	}
-
-	return n * factorial(n - 1);
-}
-
-int* generatePermutation(long idx, int permSize) {
-	int* permutation = (int *) malloc(permSize * sizeof(int));
-	for (int i1 = 0; i1 < permSize; i1++) {
-		permutation[i1] = i1 + 1;
-	}
-	if (idx != 0) {
-		//Generate perm for idx using factoradic numbers
-		int factoradicLength = 0;
-		long factorials[permSize];
-		long fac = 1;
-		int count = 0;
-		while (idx >= fac) {
-			fac = factorial(factoradicLength);
-			factorials[count] = fac;
-			count++;
-			factoradicLength++;
-		}
-		factoradicLength--;
-		//printf("Factoradic length: %d\n", factoradicLength);
-
-		long factoradic[permSize];
-		for (int i1 = 0; i1 < permSize; i1++) {
-			factoradic[i1] = 0;
-		}
-
-		//printf("Array inited\n");
-
-		long cur = idx;
-		count = 0;
-		for (int i1 = factoradicLength - 1; i1 >= 0; i1--) {
-			long fNum = cur / factorials[i1];
-			//printf("fNum = %ld\n", fNum);
-			factoradic[count + permSize - factoradicLength] = fNum;
-			count++;
-			cur = cur % factorials[i1];
-		}
-
-		int permutationTemp[permSize];
-		permutationTemp[0] = factoradic[0] + 1;
-		permutation[factoradic[0]] = -1;
-		for (int i1 = 1; i1 < permSize; i1++) {
-			int fNum = factoradic[i1];
-			int permIdx = 0;
-			int actualIdx = 0;
-			while (permIdx != fNum || permutation[actualIdx] == -1) {
-				if (permutation[actualIdx] != -1) {
-					permIdx++;
+void spawnSearchTask(struct Options* options, int permSize, struct SearchWorker** workers, struct Results* results,
+	PermIndex start, PermIndex end, PermIndex grain, int splits, std::atomic<long>* waiting) {
+	waiting->fetch_add(1);
+	#pragma omp task firstprivate(start, end, grain, splits)
+	{
+		waiting->fetch_sub(1);
+		int id = omp_get_thread_num();
+		PermIndex smaller = splits > 0 ? splitGrain(options, permSize, grain) : grain;
+		PermIndex pos = start;
+		while (pos < end && !searchStopped(&results[id])) {
+			if (smaller < grain && waiting->load() < omp_get_num_threads()) {
+				//Threads are about to run out of tasks, so hand out the rest
+				for (; pos < end; pos += smaller) {
+					PermIndex pieceEnd = pos + smaller < end ? pos + smaller : end;
+					spawnSearchTask(options, permSize, workers, results, pos, pieceEnd, smaller, splits - 1, waiting);
 				}
-				actualIdx++;
+			} else {
+				PermIndex pieceEnd = pos + smaller < end ? pos + smaller : end;
+				searchWorkerRange(workers[id], pos, pieceEnd);
+				pos = pieceEnd;
 			}
-			permutationTemp[i1] = permutation[actualIdx];
-			permutation[actualIdx] = -1;
-		}
-
-		for (int i1 = 0; i1 < permSize; i1++) {
-			permutation[i1] = permutationTemp[i1];
 		}
 	}
-
-	return permutation;
-}
-
-void printArr(int arr[], int size, int newline) {
-	printf("{");
-	for (int i1 = 0; i1 < size; i1++) {
-		printf("%d", arr[i1]);
-		if (i1 != size - 1) {
-			printf(", ");
-		}
-	}
-	printf("}");
-	if (newline) {
-		printf("\n");
-	}
 }
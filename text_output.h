@@ -0,0 +1,223 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Writing the labelings found to the text output file with threads. The
+//labelings, already sorted, are split into chunks of TEXT_CHUNK. Each thread
+//takes the next chunk, unranks it, and formats every line of it by hand into
+//a large buffer, while one more thread writes the buffers to the file in
+//chunk order with one fwrite each. The output is the same as writing the
+//lines one at a time.
+//
+//If the runtime gives only one thread, it formats and writes each chunk in
+//turn instead.
+//
+//There are TEXT_BUFFERS_PER_THREAD buffers for each formatting thread, used
+//in turn, so chunk c goes in buffer c % numBuffers. A thread waits for the
+//chunk that last used its buffer to be written before formatting into it, and
+//the writer waits for each chunk to be formatted, so memory stays bounded no
+//matter how many labelings there are.
+
+#ifndef TEXT_OUTPUT_H
+#define TEXT_OUTPUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <omp.h>
+#include <atomic>
+#include <vector>
+
+#include "perm_index.h"
+#include "perm_rank.h"
+
+#define TEXT_CHUNK 4096 //Labelings formatted into each buffer
+#define TEXT_BUFFERS_PER_THREAD 2 //Buffers for each formatting thread
+
+//Struct for a buffer of formatted lines
+struct TextBuffer {
+	char* text;
+	long length;
+
+	//The chunk in the buffer plus 1, set once it is formatted
+	std::atomic<long> ready;
+};
+
+void writeTextLabelings(FILE* outputFile, const PermIndex* worksIdxs, const int* magicNumbers, long count,
+	int permSize, int orbitSize, int numThreads);
+long formatLabelings(char* text, const PermIndex* worksIdxs, const int* magicNumbers, int count,
+	long firstNumber, int permSize, int orbitSize, int* labels);
+long textLineSize(int permSize);
+char* formatNumber(char* pos, long value);
+
+/**
+ * Write labelings to the text output file, formatting them on numThreads
+ * threads while another one writes
+ * @param outputFile The text file, with everything before the labelings
+ *                   already written
+ * @param worksIdxs The permutation indexes of the labelings, sorted
+ * @param magicNumbers The magic number of each labeling
+ * @param count How many labelings
+ * @param permSize The number of labels
+ * @param orbitSize The size of the orbit of each labeling, or 0 to leave it
+ *                  out
+ * @param numThreads How many threads format the lines
+ */
+void writeTextLabelings(FILE* outputFile, const PermIndex* worksIdxs, const int* magicNumbers, long count,
+	int permSize, int orbitSize, int numThreads) {
+	long numChunks = (count + TEXT_CHUNK - 1) / TEXT_CHUNK;
+	if (numChunks == 0) {
+		return;
+	}
+	long bufferSize = TEXT_CHUNK * textLineSize(permSize);
+	struct TextBuffer* buffers = NULL;
+	long numBuffers = 0;
+
+	//The next chunk to format, and how many have been written
+	std::atomic<long> nextChunk(0);
+	std::atomic<long> written(0);
+
+	#pragma omp parallel num_threads(numThreads + 1)
+	{
+		//The runtime can give fewer threads than asked for, so the buffers
+		//are made for the team there is
+		int teamSize = omp_get_num_threads();
+		#pragma omp single
+		{
+			numBuffers = teamSize < 2 ? 1 : (long) (teamSize - 1) * TEXT_BUFFERS_PER_THREAD;
+			if (numBuffers > numChunks) {
+				numBuffers = numChunks;
+			}
+			buffers = new struct TextBuffer[numBuffers];
+			for (long i1 = 0; i1 < numBuffers; i1++) {
+				buffers[i1].text = (char *) malloc(bufferSize);
+				buffers[i1].length = 0;
+				buffers[i1].ready = 0;
+			}
+		}
+
+		if (teamSize < 2) {
+			//With one thread, format each chunk and write it in turn
+			int* labels = (int *) malloc(TEXT_CHUNK * permSize * sizeof(int));
+			for (long chunk = 0; chunk < numChunks; chunk++) {
+				long first = chunk * TEXT_CHUNK;
+				int size = count - first < TEXT_CHUNK ? count - first : TEXT_CHUNK;
+				long length = formatLabelings(buffers[0].text, worksIdxs + first, magicNumbers + first, size,
+					first + 1, permSize, orbitSize, labels);
+				fwrite(buffers[0].text, 1, length, outputFile);
+			}
+			free(labels);
+		} else if (omp_get_thread_num() == 0) {
+			//The writer takes the chunks in order as they are formatted
+			for (long chunk = 0; chunk < numChunks; chunk++) {
+				struct TextBuffer* buffer = &buffers[chunk % numBuffers];
+				while (buffer->ready.load(std::memory_order_acquire) != chunk + 1) {
+					sched_yield();
+				}
+				fwrite(buffer->text, 1, buffer->length, outputFile);
+				written.store(chunk + 1, std::memory_order_release);
+			}
+		} else {
+			int* labels = (int *) malloc(TEXT_CHUNK * permSize * sizeof(int));
+			long chunk;
+			while ((chunk = nextChunk.fetch_add(1)) < numChunks) {
+				//Wait for the chunk that used the buffer last to be written
+				struct TextBuffer* buffer = &buffers[chunk % numBuffers];
+				while (written.load(std::memory_order_acquire) < chunk - numBuffers + 1) {
+					sched_yield();
+				}
+
+				long first = chunk * TEXT_CHUNK;
+				int size = count - first < TEXT_CHUNK ? count - first : TEXT_CHUNK;
+				buffer->length = formatLabelings(buffer->text, worksIdxs + first, magicNumbers + first, size,
+					first + 1, permSize, orbitSize, labels);
+				buffer->ready.store(chunk + 1, std::memory_order_release);
+			}
+			free(labels);
+		}
+	}
+
+	for (long i1 = 0; i1 < numBuffers; i1++) {
+		free(buffers[i1].text);
+	}
+	delete[] buffers;
+}
+
+/**
+ * Format labelings as lines of the text output file,
+ * "1: {3, 1, 2} Magic Number: 2" with " Orbit size: 4" on the end when given
+ * @param text Where to put the lines, with room for count lines of
+ *             textLineSize(permSize)
+ * @param worksIdxs The permutation indexes of the labelings
+ * @param magicNumbers The magic number of each labeling
+ * @param count How many labelings
+ * @param firstNumber The number of the first labeling, from 1
+ * @param permSize The number of labels
+ * @param orbitSize The size of the orbit of each labeling, or 0 to leave it
+ *                  out
+ * @param labels Room for count * permSize labels
+ * @return The length of the lines
+ */
+long formatLabelings(char* text, const PermIndex* worksIdxs, const int* magicNumbers, int count,
+	long firstNumber, int permSize, int orbitSize, int* labels) {
+	unrankBatch(worksIdxs, count, permSize, labels);
+	char* pos = text;
+	for (int i1 = 0; i1 < count; i1++) {
+		pos = formatNumber(pos, firstNumber + i1);
+		*pos++ = ':';
+		*pos++ = ' ';
+		*pos++ = '{';
+		int* perm = labels + i1 * permSize;
+		for (int i2 = 0; i2 < permSize; i2++) {
+			pos = formatNumber(pos, perm[i2]);
+			if (i2 != permSize - 1) {
+				*pos++ = ',';
+				*pos++ = ' ';
+			}
+		}
+		memcpy(pos, "} Magic Number: ", 16);
+		pos = formatNumber(pos + 16, magicNumbers[i1]);
+		if (orbitSize > 0) {
+			memcpy(pos, " Orbit size: ", 13);
+			pos = formatNumber(pos + 13, orbitSize);
+		}
+		*pos++ = '\n';
+	}
+	return pos - text;
+}
+
+/**
+ * The longest a line of the text output file can be
+ * @param permSize The number of labels
+ * @return The most bytes one line takes
+ */
+long textLineSize(int permSize) {
+	//The number, each label with a comma and space, and the magic number and
+	//orbit size with their words
+	return 24 + permSize * 13 + 16 + 12 + 13 + 12 + 1;
+}
+
+/**
+ * Write a number in decimal
+ * @param pos Where to write it
+ * @param value The number
+ * @return Just past the last digit
+ */
+char* formatNumber(char* pos, long value) {
+	unsigned long magnitude = value;
+	if (value < 0) {
+		*pos++ = '-';
+		magnitude = -(unsigned long) value;
+	}
+	char digits[20];
+	int length = 0;
+	do {
+		digits[length++] = '0' + magnitude % 10;
+		magnitude /= 10;
+	} while (magnitude > 0);
+	while (length > 0) {
+		*pos++ = digits[--length];
+	}
+	return pos;
+}
+
+#endif
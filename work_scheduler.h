@@ -0,0 +1,164 @@
+//CSC 350 - Parallel Computing and MAT 490/491 - Research on Graph Labelings
+//
+//Dynamic scheduling of the units of work between MPI processes. Instead of
+//each process taking one fixed block, the root hands out pieces of the units
+//to the other processes as they ask for them, so a process on a slow node or
+//with a part of the search that does not prune well just takes fewer pieces.
+//
+//Each worker keeps one request in flight: as soon as it gets a piece it asks
+//for the next one, so the reply is usually waiting by the time the piece is
+//done. With each request it sends how many units a second it got through on
+//its last piece, and the root sizes the next piece to take about
+//SCHEDULE_SECONDS at that rate. Pieces never take more than a share of what is
+//left, so they get smaller near the end and the workers finish together. An
+//empty piece tells a worker there is nothing left, after which it stops
+//asking.
+
+#ifndef WORK_SCHEDULER_H
+#define WORK_SCHEDULER_H
+
+#include <stdio.h>
+#include <mpi.h>
+
+#include "perm_index.h"
+
+#define SCHEDULE_REQUEST 101 //Tag of a request for work, holding the rate
+#define SCHEDULE_REPLY 102 //Tag of a piece of work, holding its start and end
+#define SCHEDULE_SECONDS 0.5 //How long each piece should take
+
+//Struct for a worker's side of the schedule
+struct WorkFeed {
+	MPI_Comm comm;
+	int root;
+
+	//The reply to the request in flight
+	PermIndex reply[2];
+	MPI_Request replyRequest;
+
+	//The rate sent with the request, and when and how big the piece being
+	//worked on is
+	double rate;
+	double pieceTime;
+	PermIndex pieceSize;
+};
+
+void scheduleWork(PermIndex numUnits, PermIndex firstPiece, int numWorkers, MPI_Comm comm);
+struct WorkFeed startWorkFeed(MPI_Comm comm, int root);
+int nextWork(struct WorkFeed* feed, int stop, PermIndex* start, PermIndex* end);
+void requestWork(struct WorkFeed* feed);
+
+/**
+ * Hand out pieces of work until there is none left. Run on the root while the
+ * workers work.
+ * @param numUnits The number of units of work
+ * @param firstPiece The size of the piece for a worker whose rate is not known
+ * @param numWorkers How many workers will ask for work, which can include a
+ *                   thread of the root
+ * @param comm The processes to hand out work to
+ */
+void scheduleWork(PermIndex numUnits, PermIndex firstPiece, int numWorkers, MPI_Comm comm) {
+	int totalWorkers = numWorkers;
+	PermIndex next = 0;
+	int stopped = 0;
+	int numPieces = 0;
+	while (numWorkers > 0) {
+		double rate;
+		MPI_Status status;
+		MPI_Recv(&rate, 1, MPI_DOUBLE, MPI_ANY_SOURCE, SCHEDULE_REQUEST, comm, &status);
+
+		//A negative rate means the worker found enough labelings
+		if (rate < 0) {
+			stopped = 1;
+		}
+
+		PermIndex piece[2] = {next, next};
+		if (!stopped && next < numUnits) {
+			//About SCHEDULE_SECONDS of work, but at most half of an even share
+			//of what is left
+			PermIndex remaining = numUnits - next;
+			PermIndex size = rate > 0 ? (PermIndex) (rate * SCHEDULE_SECONDS) : firstPiece;
+			PermIndex share = remaining / (2 * totalWorkers);
+			if (size > share) {
+				size = share;
+			}
+			if (size < 1) {
+				size = 1;
+			}
+			if (size > remaining) {
+				size = remaining;
+			}
+			piece[1] = next + size;
+			next += size;
+			numPieces++;
+		} else {
+			numWorkers--;
+		}
+		MPI_Send(piece, 2, permIndexType(), status.MPI_SOURCE, SCHEDULE_REPLY, comm);
+	}
+
+	printf("Pieces handed out: %d\n", numPieces);
+}
+
+/**
+ * Start asking the root for work
+ * @param comm The processes the work is shared between
+ * @param root The process handing out the work
+ * @return The worker's side of the schedule
+ */
+struct WorkFeed startWorkFeed(MPI_Comm comm, int root) {
+	struct WorkFeed feed;
+	feed.comm = comm;
+	feed.root = root;
+	feed.rate = 0;
+	feed.pieceSize = 0;
+	requestWork(&feed);
+	return feed;
+}
+
+/**
+ * Get the next piece of work, and ask for the one after it
+ * @param feed The worker's side of the schedule
+ * @param stop 1 if the worker found enough labelings and should stop
+ * @param start Set to the first unit of the piece
+ * @param end Set to one past the last unit of the piece
+ * @return 1 if there is a piece to work on, 0 if the worker is done
+ */
+int nextWork(struct WorkFeed* feed, int stop, PermIndex* start, PermIndex* end) {
+	//The rate of the piece just finished goes with the next request
+	if (feed->pieceSize > 0) {
+		double seconds = MPI_Wtime() - feed->pieceTime;
+		feed->rate = seconds > 0 ? (double) feed->pieceSize / seconds : 0;
+	}
+
+	MPI_Wait(&feed->replyRequest, MPI_STATUS_IGNORE);
+	*start = feed->reply[0];
+	*end = feed->reply[1];
+	if (*start == *end) {
+		return 0;
+	}
+
+	//Drop the piece and tell the root to stop handing out work, then wait
+	//for the empty piece that ends this worker
+	if (stop) {
+		feed->rate = -1;
+		requestWork(feed);
+		MPI_Wait(&feed->replyRequest, MPI_STATUS_IGNORE);
+		return 0;
+	}
+
+	requestWork(feed);
+	feed->pieceTime = MPI_Wtime();
+	feed->pieceSize = *end - *start;
+	return 1;
+}
+
+/**
+ * Send a request for work and get ready for the reply
+ * @param feed The worker's side of the schedule
+ */
+void requestWork(struct WorkFeed* feed) {
+	MPI_Send(&feed->rate, 1, MPI_DOUBLE, feed->root, SCHEDULE_REQUEST, feed->comm);
+	MPI_Irecv(feed->reply, 2, permIndexType(), feed->root, SCHEDULE_REPLY, feed->comm, &feed->replyRequest);
+}
+
+#endif